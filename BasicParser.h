@@ -0,0 +1,382 @@
+#ifndef BASIC_PARSER_H
+#define BASIC_PARSER_H
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Lexer.h"
+#include "PositionPolicy.h"
+
+/**
+ * The parse loop, specialized at compile time for what is done with the
+ * parsed values, how positions are tracked and where its working storage
+ * comes from. The input is scanned directly rather than through a Lexer,
+ * so a specialization does only the work its policies ask for.
+ *
+ * The Sink receives the document as a sequence of events, SAX style:
+ *
+ *     void startObject(size_t offset);   // offset of the '{'
+ *     void endObject(size_t end);        // offset just past the '}'
+ *     void startArray(size_t offset);
+ *     void endArray(size_t end);
+ *     void key(std::string_view key);
+ *     void string(std::string_view value);
+ *     void number(std::string_view text);
+ *     void boolean(bool value);
+ *     void null();
+ *
+ * Strings are passed decoded. The views are valid only during the call.
+ * DomSink builds a tree, ValidateSink discards everything, and any other
+ * class with these members can consume the events directly.
+ *
+ * Position is TrackPosition or NoPosition. Allocator provides the stack of
+ * open objects and arrays.
+ */
+template <typename Sink, typename Position = NoPosition, typename Allocator = std::allocator<char>>
+class BasicParser
+{
+public:
+    /**
+     * Creates a parser for a JSON text. The text must outlive the parser.
+     *
+     * @param input the JSON text
+     * @param maxDepth maximum nesting depth of objects and arrays
+     * @param baseDepth nesting depth of the position the text is parsed at
+     * @param allocator allocator for the parser's working storage
+     */
+    BasicParser(const std::string &input, size_t maxDepth = DEFAULT_MAX_DEPTH, size_t baseDepth = 0,
+                const Allocator &allocator = Allocator())
+        : data(input.c_str()), size(input.size()), maxDepth(maxDepth), baseDepth(baseDepth), stack(allocator) {}
+
+    /**
+     * Points the parser at another text. The storage the parser has grown
+     * is kept for it. The text must outlive the parser's use of it.
+     *
+     * @param input the JSON text
+     * @param baseDepth nesting depth of the position the text is parsed at
+     */
+    void reset(const std::string &input, size_t baseDepth = 0)
+    {
+        data = input.c_str();
+        size = input.size();
+        this->baseDepth = baseDepth;
+    }
+
+    /**
+     * Parses the whole text as a single JSON value, sending its events to a sink.
+     *
+     * @param sink the sink to receive the events
+     *
+     * @throws {std::runtime_error} if the text is not valid JSON or nests deeper than maxDepth
+     */
+    void parse(Sink &sink)
+    {
+        pos = 0;
+        position = Position();
+        stack.clear();
+        stats = StatCounters();
+        skipWhitespace();
+
+        while (true)
+        {
+            char c = data[pos];
+            if (c == '{' || c == '[')
+            {
+                if (baseDepth + stack.size() >= maxDepth)
+                {
+                    fail("Maximum nesting depth of " + std::to_string(maxDepth) + " exceeded");
+                }
+
+                bool isObject = c == '{';
+                JSON_STATS_ADD(stats, tokensProduced, 1);
+                if (isObject)
+                {
+                    sink.startObject(pos);
+                }
+                else
+                {
+                    sink.startArray(pos);
+                }
+                pos++;
+                skipWhitespace();
+
+                if (data[pos] != (isObject ? '}' : ']'))
+                {
+                    stack.push_back(isObject);
+                    if (isObject)
+                    {
+                        parseKey(sink);
+                    }
+                    continue;
+                }
+
+                JSON_STATS_ADD(stats, tokensProduced, 1);
+                pos++;
+                if (isObject)
+                {
+                    sink.endObject(pos);
+                }
+                else
+                {
+                    sink.endArray(pos);
+                }
+            }
+            else
+            {
+                parseScalar(sink);
+            }
+
+            // A value is complete; consume separators and the ends of the containers it completes.
+            while (true)
+            {
+                skipWhitespace();
+                if (stack.empty())
+                {
+                    if (pos != size)
+                    {
+                        fail("Unexpected characters at the end of JSON input");
+                    }
+                    JSON_STATS_ADD(stats, bytesScanned, size);
+                    JSON_STATS_PUBLISH(stats);
+                    return;
+                }
+
+                bool isObject = stack.back();
+                JSON_STATS_ADD(stats, tokensProduced, 1);
+                if (data[pos] == ',')
+                {
+                    pos++;
+                    skipWhitespace();
+                    if (isObject)
+                    {
+                        parseKey(sink);
+                    }
+                    break;
+                }
+
+                if (data[pos] != (isObject ? '}' : ']'))
+                {
+                    fail(isObject ? "Expected ',' or '}' in object" : "Expected ',' or ']' in array");
+                }
+
+                pos++;
+                stack.pop_back();
+                if (isObject)
+                {
+                    sink.endObject(pos);
+                }
+                else
+                {
+                    sink.endArray(pos);
+                }
+            }
+        }
+    }
+
+    /**
+     * Gets the line of the current position.
+     * @return Current line number.
+     */
+    size_t getLine() const
+    {
+        return position.getLine(data, pos);
+    }
+
+    /**
+     * Gets the column of the current position.
+     * @return Current column number.
+     */
+    size_t getColumn() const
+    {
+        return position.getColumn(data, pos);
+    }
+
+private:
+    using Stack = std::vector<char, typename std::allocator_traits<Allocator>::template rebind_alloc<char>>;
+
+    /**
+     * Skips whitespace. The input ends with a NUL character, which is not
+     * whitespace, so no bounds check is needed.
+     */
+    void skipWhitespace()
+    {
+        while (CharClass::isWhitespace(data[pos]))
+        {
+            position.whitespace(data[pos], pos);
+            pos++;
+        }
+    }
+
+    /**
+     * Parses an object key and the colon following it.
+     */
+    void parseKey(Sink &sink)
+    {
+        if (data[pos] != '"')
+        {
+            fail("Expected string key in object");
+        }
+        sink.key(parseString());
+
+        skipWhitespace();
+        if (data[pos] != ':')
+        {
+            fail("Expected ':' after key in object");
+        }
+        JSON_STATS_ADD(stats, tokensProduced, 1);
+        pos++;
+        skipWhitespace();
+    }
+
+    /**
+     * Parses a string, number, boolean or null value.
+     */
+    void parseScalar(Sink &sink)
+    {
+        char c = data[pos];
+        if (c == '"')
+        {
+            sink.string(parseString());
+        }
+        else if (CharClass::isDigit(c) || c == '-')
+        {
+            size_t start = pos;
+            while (CharClass::isNumber(data[pos]))
+            {
+                pos++;
+            }
+            std::string_view text(data + start, pos - start);
+            if (!CharClass::isValidNumber(text))
+            {
+                pos = start;
+                fail("Invalid number '" + std::string(text) + "'");
+            }
+            JSON_STATS_ADD(stats, tokensProduced, 1);
+            sink.number(text);
+        }
+        else if (CharClass::isAlpha(c))
+        {
+            size_t start = pos;
+            while (CharClass::isAlpha(data[pos]))
+            {
+                pos++;
+            }
+            JSON_STATS_ADD(stats, tokensProduced, 1);
+
+            std::string_view keyword(data + start, pos - start);
+            if (keyword == "true" || keyword == "false")
+            {
+                sink.boolean(keyword[0] == 't');
+            }
+            else if (keyword == "null")
+            {
+                sink.null();
+            }
+            else
+            {
+                pos = start;
+                fail("Invalid keyword '" + std::string(keyword) + "'");
+            }
+        }
+        else if (pos == size)
+        {
+            fail("Unexpected end of JSON input");
+        }
+        else
+        {
+            fail("Unexpected character");
+        }
+    }
+
+    /**
+     * Parses a string starting at its opening quote, decoding escape sequences.
+     *
+     * @return the decoded string, pointing into the input if it has no escapes
+     */
+    std::string_view parseString()
+    {
+        size_t start = pos + 1;
+        size_t end = start;
+        bool escaped = false;
+
+        while (true)
+        {
+            end += StringCodec::findSpecial(data + end, size - end);
+            if (end >= size)
+            {
+                fail("Unterminated string");
+            }
+
+            char c = data[end];
+            if (c == '"')
+            {
+                break;
+            }
+            if (c != '\\')
+            {
+                pos = end;
+                fail("Unescaped control character in string");
+            }
+
+            // The escaped character is checked when the string is decoded.
+            escaped = true;
+            end = std::min(end + 2, size);
+        }
+
+        size_t invalid = StringCodec::validateUtf8(data + start, end - start);
+        if (invalid != end - start)
+        {
+            pos = start + invalid;
+            fail("Invalid UTF-8 in string");
+        }
+
+        JSON_STATS_ADD(stats, tokensProduced, 1);
+        if (!escaped)
+        {
+            pos = end + 1;
+            return std::string_view(data + start, end - start);
+        }
+
+        try
+        {
+            StringCodec::unescape(data + start, end - start, scratch);
+        }
+        catch (const std::runtime_error &e)
+        {
+            fail(e.what());
+        }
+        pos = end + 1;
+        return scratch;
+    }
+
+    /**
+     * Throws a std::runtime_error with a message and the current position.
+     *
+     * @param message message to display in the error
+     */
+    [[noreturn]] void fail(const std::string &message)
+    {
+        JSON_STATS_ADD(stats, bytesScanned, pos);
+        JSON_STATS_PUBLISH(stats);
+        throw std::runtime_error(message + " at line " + std::to_string(getLine()) + ", column " + std::to_string(getColumn()));
+    }
+
+private:
+    const char *data;
+    size_t size;
+    size_t pos = 0;
+    size_t maxDepth;
+    size_t baseDepth;
+    Position position;
+
+    // true for an open object, false for an open array
+    Stack stack;
+    std::string scratch;
+
+    StatCounters stats;
+};
+
+#endif
@@ -0,0 +1,158 @@
+#include "BulkValidator.h"
+#include "ChunkReader.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+
+#include <glob.h>
+
+double BulkValidationSummary::throughputMbPerSecond() const
+{
+    return seconds > 0 ? totalBytes / (1024.0 * 1024.0) / seconds : 0;
+}
+
+namespace
+{
+    bool endsWith(const std::string &text, const std::string &suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    bool isJsonFile(const std::string &path)
+    {
+        return endsWith(path, ".json") || endsWith(path, ".json.gz") || endsWith(path, ".json.zst");
+    }
+}
+
+std::vector<std::string> BulkValidator::findFiles(const std::string &pattern)
+{
+    std::vector<std::string> files;
+    std::error_code error;
+
+    if (std::filesystem::is_directory(pattern, error))
+    {
+        auto options = std::filesystem::directory_options::skip_permission_denied;
+        for (auto it = std::filesystem::recursive_directory_iterator(pattern, options, error);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+        {
+            if (error)
+            {
+                break;
+            }
+            if (it->is_regular_file(error) && isJsonFile(it->path().string()))
+            {
+                files.push_back(it->path().string());
+            }
+        }
+    }
+    else
+    {
+        glob_t matches;
+        if (::glob(pattern.c_str(), 0, nullptr, &matches) == 0)
+        {
+            for (size_t i = 0; i < matches.gl_pathc; i++)
+            {
+                if (std::filesystem::is_regular_file(matches.gl_pathv[i], error))
+                {
+                    files.push_back(matches.gl_pathv[i]);
+                }
+            }
+        }
+        ::globfree(&matches);
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+BulkValidationSummary BulkValidator::validateAll(const std::vector<std::string> &files, size_t threads, size_t maxDepth,
+                                                const Schema *schema)
+{
+    BulkValidationSummary summary;
+    summary.files.resize(files.size());
+
+    std::vector<size_t> order(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(files[i], error);
+        summary.files[i].path = files[i];
+        summary.files[i].bytes = error ? 0 : static_cast<size_t>(size);
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                     { return summary.files[a].bytes > summary.files[b].bytes; });
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(threads);
+        summary.threads = pool.size();
+        for (size_t index : order)
+        {
+            FileValidation &result = summary.files[index];
+            pool.submit([&result, maxDepth, schema]()
+                        { validateFile(result.path, maxDepth, schema, result); });
+        }
+        pool.wait();
+    }
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const FileValidation &result : summary.files)
+    {
+        summary.totalBytes += result.bytes;
+        (result.valid ? summary.validCount : summary.invalidCount)++;
+    }
+    return summary;
+}
+
+void BulkValidator::print(const BulkValidationSummary &summary, std::ostream &out)
+{
+    for (const FileValidation &result : summary.files)
+    {
+        if (result.valid)
+        {
+            out << "OK      " << result.path << std::endl;
+        }
+        else
+        {
+            out << "INVALID " << result.path << ": " << result.error << std::endl;
+        }
+    }
+
+    out << std::fixed << std::setprecision(2);
+    out << summary.files.size() << " files, " << summary.validCount << " valid, " << summary.invalidCount << " invalid; "
+        << summary.totalBytes / (1024.0 * 1024.0) << " MB in " << summary.seconds << " s ("
+        << summary.throughputMbPerSecond() << " MB/s on " << summary.threads << " threads)" << std::endl;
+    out << std::defaultfloat << std::setprecision(6);
+}
+
+void BulkValidator::validateFile(const std::string &path, size_t maxDepth, const Schema *schema, FileValidation &result)
+{
+    std::string input;
+    {
+        JSON_STATS_PHASE(Phase::READ);
+        try
+        {
+            input = ChunkReader::readAll(path);
+        }
+        catch (const std::exception &e)
+        {
+            result.error = e.what();
+            return;
+        }
+    }
+    result.bytes = input.size();
+
+    try
+    {
+        Validator validator(Lexer(std::move(input)), maxDepth);
+        result.valid = schema ? validator.validate(*schema, result.error) : validator.validate(result.error);
+    }
+    catch (const std::exception &e)
+    {
+        result.error = e.what();
+    }
+}
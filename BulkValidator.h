@@ -0,0 +1,89 @@
+#ifndef BULK_VALIDATOR_H
+#define BULK_VALIDATOR_H
+
+#include "Validator.h"
+
+#include <vector>
+
+/**
+ * Outcome of validating one file.
+ */
+struct FileValidation
+{
+    std::string path;
+    size_t bytes = 0;
+    bool valid = false;
+    std::string error;
+};
+
+/**
+ * Outcome of validating a batch of files.
+ */
+struct BulkValidationSummary
+{
+    std::vector<FileValidation> files;
+    size_t validCount = 0;
+    size_t invalidCount = 0;
+    size_t totalBytes = 0;
+    double seconds = 0;
+    size_t threads = 0;
+
+    /**
+     * Returns the number of megabytes validated per second.
+     */
+    double throughputMbPerSecond() const;
+};
+
+/**
+ * Validates many files concurrently on a thread pool. Files are only lexed
+ * and checked, never parsed into JSONValue trees.
+ */
+class BulkValidator
+{
+public:
+    /**
+     * Lists the files a pattern names: every .json, .json.gz or .json.zst file
+     * under it, recursively, if it is a directory, otherwise the paths
+     * matching it as a shell glob.
+     *
+     * @param pattern a directory or a glob such as data/[0-9]*.json
+     *
+     * @return the matching files, sorted by path
+     */
+    static std::vector<std::string> findFiles(const std::string &pattern);
+
+    /**
+     * Validates files concurrently. Larger files are started first, so a
+     * large file does not keep one thread busy after all others are done.
+     *
+     * @param files the files to validate
+     * @param threads number of threads, 0 for one per hardware thread
+     * @param maxDepth maximum nesting depth of objects and arrays
+     * @param schema if given, every file is also checked against this schema
+     *
+     * @return per-file results in the order of files, and the totals
+     */
+    static BulkValidationSummary validateAll(const std::vector<std::string> &files, size_t threads = 0,
+                                             size_t maxDepth = DEFAULT_MAX_DEPTH, const Schema *schema = nullptr);
+
+    /**
+     * Prints a line per file and the totals.
+     *
+     * @param summary the results to print
+     * @param out the stream to print to
+     */
+    static void print(const BulkValidationSummary &summary, std::ostream &out);
+
+private:
+    /**
+     * Reads and validates one file.
+     *
+     * @param path the file to validate
+     * @param maxDepth maximum nesting depth of objects and arrays
+     * @param schema the schema to check the file against, or nullptr
+     * @param result receives the outcome
+     */
+    static void validateFile(const std::string &path, size_t maxDepth, const Schema *schema, FileValidation &result);
+};
+
+#endif
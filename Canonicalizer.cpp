@@ -0,0 +1,205 @@
+#include "Canonicalizer.h"
+#include "StringCodec.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    /**
+     * Text is handed to the stream whenever the buffer grows past this size.
+     */
+    const size_t FLUSH_SIZE = 64 * 1024;
+
+    /**
+     * An object or array whose members are being written.
+     */
+    struct CanonicalFrame
+    {
+        const JSONValue *container;
+        size_t index;
+        // objects: positions of the members in sorted key order
+        const std::vector<uint32_t> *order;
+    };
+
+    void flush(std::ostream &out, std::string &buffer)
+    {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+}
+
+void Canonicalizer::write(std::ostream &out, const JSONValue *jsonValue)
+{
+    std::string buffer;
+    buffer.reserve(FLUSH_SIZE + 1024);
+    std::vector<CanonicalFrame> stack;
+
+    auto open = [&](const JSONValue *value)
+    {
+        if (!appendOpening(buffer, value))
+        {
+            return;
+        }
+        const std::vector<uint32_t> *order = nullptr;
+        if (value->getType() == JSONValueType::OBJECT)
+        {
+            order = &static_cast<const JSONObject *>(value)->getSortedOrder();
+        }
+        stack.push_back({value, 0, order});
+    };
+
+    open(jsonValue);
+    while (!stack.empty())
+    {
+        if (buffer.size() >= FLUSH_SIZE)
+        {
+            flush(out, buffer);
+        }
+
+        CanonicalFrame &frame = stack.back();
+        const JSONValue *member;
+        if (frame.order)
+        {
+            const auto &values = static_cast<const JSONObject *>(frame.container)->getValues();
+            if (frame.index == values.size())
+            {
+                buffer += '}';
+                stack.pop_back();
+                continue;
+            }
+
+            const std::string &key = values[(*frame.order)[frame.index]].key;
+            if (frame.index > 0)
+            {
+                // Equal keys are next to each other in sorted order.
+                if (key == values[(*frame.order)[frame.index - 1]].key)
+                {
+                    throw std::runtime_error("key \"" + key + "\" appears twice in an object, which has no canonical form");
+                }
+                buffer += ',';
+            }
+            StringCodec::appendQuoted(buffer, key);
+            buffer += ':';
+            member = values[(*frame.order)[frame.index]].value.get();
+        }
+        else
+        {
+            const auto &values = static_cast<const JSONArray *>(frame.container)->getValues();
+            if (frame.index == values.size())
+            {
+                buffer += ']';
+                stack.pop_back();
+                continue;
+            }
+
+            if (frame.index > 0)
+            {
+                buffer += ',';
+            }
+            member = values[frame.index].get();
+        }
+        frame.index++;
+        open(member);
+    }
+
+    flush(out, buffer);
+}
+
+void Canonicalizer::appendNumber(std::string &out, double value)
+{
+    if (!std::isfinite(value))
+    {
+        throw std::runtime_error("a number that is not finite has no canonical form");
+    }
+    if (value == 0)
+    {
+        // Both 0 and -0 are written as 0.
+        out += '0';
+        return;
+    }
+
+    // Shortest round-trip digits in the form [-]d[.ddd]e[+-]x.
+    char text[32];
+    char *end = std::to_chars(text, text + sizeof(text), value, std::chars_format::scientific).ptr;
+    const char *p = text;
+    if (*p == '-')
+    {
+        out += '-';
+        p++;
+    }
+
+    char digits[20];
+    size_t count = 0;
+    for (; *p != 'e'; p++)
+    {
+        if (*p != '.')
+        {
+            digits[count++] = *p;
+        }
+    }
+    int exponent = 0;
+    std::from_chars(p[1] == '+' ? p + 2 : p + 1, end, exponent);
+
+    // The decimal point comes after this many digits.
+    int point = exponent + 1;
+    int size = static_cast<int>(count);
+    if (size <= point && point <= 21)
+    {
+        out.append(digits, count);
+        out.append(point - size, '0');
+    }
+    else if (0 < point && point <= 21)
+    {
+        out.append(digits, point);
+        out += '.';
+        out.append(digits + point, count - point);
+    }
+    else if (-6 < point && point <= 0)
+    {
+        out += "0.";
+        out.append(-point, '0');
+        out.append(digits, count);
+    }
+    else
+    {
+        out += digits[0];
+        if (count > 1)
+        {
+            out += '.';
+            out.append(digits + 1, count - 1);
+        }
+        out += exponent < 0 ? "e-" : "e+";
+        out += std::to_string(std::abs(exponent));
+    }
+}
+
+bool Canonicalizer::appendOpening(std::string &out, const JSONValue *jsonValue)
+{
+    switch (jsonValue->getType())
+    {
+    case JSONValueType::STRING:
+        StringCodec::appendQuoted(out, static_cast<const JSONString *>(jsonValue)->getValue());
+        break;
+    case JSONValueType::NUMBER:
+        appendNumber(out, static_cast<const JSONNumber *>(jsonValue)->getValue());
+        break;
+    case JSONValueType::BOOL:
+        out += static_cast<const JSONBool *>(jsonValue)->getValue() ? "true" : "false";
+        break;
+    case JSONValueType::OBJECT:
+        out += '{';
+        return true;
+    case JSONValueType::ARRAY:
+        out += '[';
+        return true;
+    case JSONValueType::NILL:
+        out += "null";
+        break;
+    }
+
+    return false;
+}
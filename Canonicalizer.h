@@ -0,0 +1,64 @@
+#ifndef CANONICALIZER_H
+#define CANONICALIZER_H
+
+#include <iostream>
+#include <string>
+
+#include "JSONValue.h"
+#include "JSONString.h"
+#include "JSONNumber.h"
+#include "JSONObject.h"
+#include "JSONArray.h"
+#include "JSONBool.h"
+
+/**
+ * Writes JSON in the canonical form of the JSON Canonicalization Scheme
+ * (RFC 8785), so that equal documents are written byte for byte the same
+ * and can be hashed or signed: no whitespace, object keys sorted by UTF-16
+ * code units, strings with only the escapes JSON requires, and numbers
+ * written the way ECMAScript writes doubles.
+ *
+ * Keys are visited through JSONObject::getSortedOrder, which keeps the
+ * sorted order of each object between writes instead of sorting a copy of
+ * its members every time. The text is built in a buffer that is handed to
+ * the stream in large blocks.
+ */
+class Canonicalizer
+{
+public:
+    /**
+     * Writes a JSON value in canonical form. Nested objects and arrays are
+     * walked with an explicit stack, so any depth can be written.
+     *
+     * @param out the stream to write to
+     * @param jsonValue the JSON value to write
+     *
+     * @throws {std::runtime_error} if an object has a key twice, which has no canonical form
+     */
+    static void write(std::ostream &out, const JSONValue *jsonValue);
+
+    /**
+     * Appends a number as ECMAScript writes it: the shortest digits that
+     * read back as the same double, in plain notation from 1e-6 up to
+     * 1e21 and in exponent notation, as in 1e+21, outside that range.
+     *
+     * @param out the string to append to
+     * @param value the number to append
+     *
+     * @throws {std::runtime_error} if the number is not finite
+     */
+    static void appendNumber(std::string &out, double value);
+
+private:
+    /**
+     * Appends a scalar value, or the opening bracket of an object or array.
+     *
+     * @param out the string to append to
+     * @param jsonValue the JSON value to append
+     *
+     * @return true if the value is an object or array whose members still have to be written
+     */
+    static bool appendOpening(std::string &out, const JSONValue *jsonValue);
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef CHAR_CLASS_H
+#define CHAR_CLASS_H
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * Lookup table of the character classes JSON cares about, built at compile time.
+ */
+struct CharClassTable
+{
+    unsigned char flags[256];
+
+    constexpr CharClassTable() : flags()
+    {
+        flags[static_cast<unsigned char>(' ')] |= 1;
+        flags[static_cast<unsigned char>('\t')] |= 1;
+        flags[static_cast<unsigned char>('\n')] |= 1;
+        flags[static_cast<unsigned char>('\r')] |= 1;
+
+        for (char c = '0'; c <= '9'; c++)
+        {
+            flags[static_cast<unsigned char>(c)] |= 2 | 8;
+        }
+        for (char c = 'a'; c <= 'z'; c++)
+        {
+            flags[static_cast<unsigned char>(c)] |= 4;
+        }
+        for (char c = 'A'; c <= 'Z'; c++)
+        {
+            flags[static_cast<unsigned char>(c)] |= 4;
+        }
+
+        flags[static_cast<unsigned char>('"')] |= 16;
+        flags[static_cast<unsigned char>('{')] |= 16;
+        flags[static_cast<unsigned char>('}')] |= 16;
+        flags[static_cast<unsigned char>('[')] |= 16;
+        flags[static_cast<unsigned char>(']')] |= 16;
+
+        flags[static_cast<unsigned char>('.')] |= 8;
+        flags[static_cast<unsigned char>('-')] |= 8;
+        flags[static_cast<unsigned char>('+')] |= 8;
+        flags[static_cast<unsigned char>('e')] |= 8;
+        flags[static_cast<unsigned char>('E')] |= 8;
+    }
+};
+
+/**
+ * Classifies characters by table lookup. Unlike isspace, isdigit and isalpha
+ * the result does not depend on the locale, only JSON's four whitespace
+ * characters count as whitespace, and bytes above 0x7F are never matched.
+ */
+class CharClass
+{
+public:
+    static constexpr unsigned char WHITESPACE = 1;
+    static constexpr unsigned char DIGIT = 2;
+    static constexpr unsigned char ALPHA = 4;
+    static constexpr unsigned char NUMBER = 8;
+    static constexpr unsigned char STRUCTURAL = 16;
+
+    /**
+     * Returns true for space, tab, line feed and carriage return.
+     */
+    static constexpr bool isWhitespace(char c)
+    {
+        return table.flags[static_cast<unsigned char>(c)] & WHITESPACE;
+    }
+
+    /**
+     * Returns true for the ASCII digits.
+     */
+    static constexpr bool isDigit(char c)
+    {
+        return table.flags[static_cast<unsigned char>(c)] & DIGIT;
+    }
+
+    /**
+     * Returns true for the ASCII letters.
+     */
+    static constexpr bool isAlpha(char c)
+    {
+        return table.flags[static_cast<unsigned char>(c)] & ALPHA;
+    }
+
+    /**
+     * Returns true for the characters a number token is made of: digits, '.', '-', '+', 'e' and 'E'.
+     */
+    static constexpr bool isNumber(char c)
+    {
+        return table.flags[static_cast<unsigned char>(c)] & NUMBER;
+    }
+
+    /**
+     * Returns true if a run of number characters is a number as RFC 8259
+     * defines it: an optional minus, an integer part without leading zeros,
+     * then optionally a fraction and an exponent, each with at least one digit.
+     */
+    static constexpr bool isValidNumber(std::string_view text)
+    {
+        size_t pos = 0;
+        size_t size = text.size();
+        if (pos < size && text[pos] == '-')
+        {
+            pos++;
+        }
+        if (pos == size || !isDigit(text[pos]))
+        {
+            return false;
+        }
+        if (text[pos] == '0')
+        {
+            pos++;
+        }
+        else
+        {
+            pos = skipDigits(text, pos);
+        }
+
+        if (pos < size && text[pos] == '.')
+        {
+            size_t digits = ++pos;
+            pos = skipDigits(text, pos);
+            if (pos == digits)
+            {
+                return false;
+            }
+        }
+        if (pos < size && (text[pos] == 'e' || text[pos] == 'E'))
+        {
+            pos++;
+            if (pos < size && (text[pos] == '+' || text[pos] == '-'))
+            {
+                pos++;
+            }
+            size_t digits = pos;
+            pos = skipDigits(text, pos);
+            if (pos == digits)
+            {
+                return false;
+            }
+        }
+        return pos == size;
+    }
+
+    /**
+     * Returns true for quotes and brackets, the characters that matter when skipping over a value.
+     */
+    static constexpr bool isStructural(char c)
+    {
+        return table.flags[static_cast<unsigned char>(c)] & STRUCTURAL;
+    }
+
+private:
+    static constexpr size_t skipDigits(std::string_view text, size_t pos)
+    {
+        while (pos < text.size() && isDigit(text[pos]))
+        {
+            pos++;
+        }
+        return pos;
+    }
+
+    static constexpr CharClassTable table{};
+};
+
+#endif
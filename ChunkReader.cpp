@@ -0,0 +1,188 @@
+#include "ChunkReader.h"
+
+#include <chrono>
+#include <stdexcept>
+
+#include "Stats.h"
+
+namespace
+{
+    // Compressed bytes are decompressed in steps of this size, so that a
+    // chunk does not grow far beyond CHUNK_SIZE.
+    const size_t RAW_STEP = 64 * 1024;
+}
+
+ChunkReader::ChunkReader(const std::string &path) : ChunkReader(path, true) {}
+
+ChunkReader::ChunkReader(const std::string &path, bool background)
+{
+    file.open(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Could not read file " + path);
+    }
+
+    // The magic bytes are kept as the start of the first chunk.
+    raw.resize(4);
+    file.read(&raw[0], static_cast<std::streamsize>(raw.size()));
+    raw.resize(static_cast<size_t>(file.gcount()));
+    format = Compression::detect(raw.data(), raw.size());
+    if (format != CompressionFormat::NONE)
+    {
+        decompressor.reset(new Decompressor(format));
+        rawBuffer.resize(RAW_STEP);
+    }
+
+    if (background)
+    {
+        thread = std::thread(&ChunkReader::run, this);
+    }
+}
+
+ChunkReader::~ChunkReader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+bool ChunkReader::next(std::string &chunk)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]()
+                 { return full[consumeIndex] || finished; });
+
+    if (full[consumeIndex])
+    {
+        chunk.swap(slots[consumeIndex]);
+        full[consumeIndex] = false;
+        consumeIndex ^= 1;
+        changed.notify_all();
+        return true;
+    }
+
+    if (!error.empty())
+    {
+        throw std::runtime_error(error);
+    }
+    return false;
+}
+
+CompressionFormat ChunkReader::getFormat() const
+{
+    return format;
+}
+
+std::string ChunkReader::readAll(const std::string &path)
+{
+    ChunkReader reader(path, false);
+    std::string text;
+    std::string chunk;
+    while (reader.produce(chunk))
+    {
+        text += chunk;
+    }
+    return text;
+}
+
+bool ChunkReader::produce(std::string &chunk)
+{
+    chunk.clear();
+
+    if (format == CompressionFormat::NONE)
+    {
+        chunk.append(raw);
+        raw.clear();
+
+        size_t used = chunk.size();
+        chunk.resize(CHUNK_SIZE);
+        file.read(&chunk[used], static_cast<std::streamsize>(CHUNK_SIZE - used));
+        chunk.resize(used + static_cast<size_t>(file.gcount()));
+    }
+    else
+    {
+        if (!raw.empty())
+        {
+            decompressor->feed(raw.data(), raw.size(), chunk);
+            raw.clear();
+        }
+
+        while (chunk.size() < CHUNK_SIZE)
+        {
+            file.read(&rawBuffer[0], static_cast<std::streamsize>(rawBuffer.size()));
+            size_t count = static_cast<size_t>(file.gcount());
+            if (count == 0)
+            {
+                // Data decoded before a truncation is still handed out; the
+                // error comes with the next chunk.
+                if (chunk.empty())
+                {
+                    decompressor->finish();
+                }
+                break;
+            }
+            decompressor->feed(rawBuffer.data(), count, chunk);
+        }
+    }
+
+    if (file.bad())
+    {
+        throw std::runtime_error("Could not read file");
+    }
+    return !chunk.empty();
+}
+
+void ChunkReader::run()
+{
+    size_t index = 0;
+    // Only the time spent reading counts, not the time spent waiting for a free slot.
+    std::chrono::steady_clock::duration readTime{};
+    try
+    {
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]()
+                             { return !full[index] || stopping; });
+                if (stopping)
+                {
+                    break;
+                }
+            }
+
+            // A slot that is not full belongs to this thread.
+            auto start = std::chrono::steady_clock::now();
+            bool more = produce(slots[index]);
+            readTime += std::chrono::steady_clock::now() - start;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!more)
+            {
+                finished = true;
+                changed.notify_all();
+                break;
+            }
+            full[index] = true;
+            index ^= 1;
+            changed.notify_all();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = e.what();
+        finished = true;
+        changed.notify_all();
+    }
+
+#if JSON_PARSER_STATS
+    Stats::recordPhase(Phase::READ, std::chrono::duration_cast<std::chrono::nanoseconds>(readTime).count());
+#endif
+}
@@ -0,0 +1,109 @@
+#ifndef CHUNK_READER_H
+#define CHUNK_READER_H
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "Compression.h"
+
+/**
+ * Reads a file in chunks, decompressing it on the way if it is gzip or
+ * zstd compressed, which is recognised by its magic bytes.
+ *
+ * Reading and decompressing happen on a thread of the reader's own, one
+ * chunk ahead of the consumer: while the consumer works on one chunk, the
+ * next one is prepared in a second buffer. Decompression thus overlaps
+ * with parsing, and at most two chunks are held at a time. The time the
+ * thread spends reading is recorded as one call of the read phase.
+ */
+class ChunkReader
+{
+public:
+    /**
+     * Bytes of decompressed data a chunk holds, except for the last one.
+     */
+    static const size_t CHUNK_SIZE = 1 << 20;
+
+    /**
+     * Opens a file and starts reading it.
+     *
+     * @param path path to the file
+     *
+     * @throws {std::runtime_error} if the file cannot be opened or its compression is not supported by this build
+     */
+    ChunkReader(const std::string &path);
+
+    /**
+     * Stops reading and waits for the reading thread to finish.
+     */
+    ~ChunkReader();
+
+    ChunkReader(const ChunkReader &) = delete;
+    ChunkReader &operator=(const ChunkReader &) = delete;
+
+    /**
+     * Takes the next chunk, waiting for it if it is not ready yet.
+     *
+     * @param chunk receives the chunk; the storage it held is reused for later chunks
+     *
+     * @return false at the end of the file
+     * @throws {std::runtime_error} if the file cannot be read or its data is corrupt
+     */
+    bool next(std::string &chunk);
+
+    /**
+     * Returns the compression the file was found to use.
+     */
+    CompressionFormat getFormat() const;
+
+    /**
+     * Reads a whole file on the calling thread, decompressing it if needed.
+     *
+     * @param path path to the file
+     *
+     * @return the contents of the file
+     * @throws {std::runtime_error} if the file cannot be read or its data is corrupt
+     */
+    static std::string readAll(const std::string &path);
+
+private:
+    /**
+     * Opens a file, and starts the reading thread if asked to.
+     */
+    ChunkReader(const std::string &path, bool background);
+
+    /**
+     * Reads and decompresses the next chunk of the file.
+     *
+     * @param chunk receives the chunk, replacing what it held
+     *
+     * @return false at the end of the file
+     */
+    bool produce(std::string &chunk);
+
+    /**
+     * Body of the reading thread.
+     */
+    void run();
+
+private:
+    std::ifstream file;
+    CompressionFormat format = CompressionFormat::NONE;
+    std::unique_ptr<Decompressor> decompressor;
+    std::string raw;
+    std::string rawBuffer;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::string slots[2];
+    bool full[2] = {false, false};
+    size_t consumeIndex = 0;
+    bool finished = false;
+    bool stopping = false;
+    std::string error;
+    std::thread thread;
+};
+
+#endif
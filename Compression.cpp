@@ -0,0 +1,411 @@
+#include "Compression.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef JSON_PARSER_GZIP
+#define JSON_PARSER_GZIP 0
+#endif
+#ifndef JSON_PARSER_ZSTD
+#define JSON_PARSER_ZSTD 0
+#endif
+
+#if JSON_PARSER_GZIP
+#include <zlib.h>
+#endif
+#if JSON_PARSER_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+    const size_t OUTPUT_STEP = 64 * 1024;
+
+    bool endsWith(const std::string &text, const std::string &suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    void requireSupport(CompressionFormat format)
+    {
+        if (!Compression::isSupported(format))
+        {
+            throw std::runtime_error(Compression::name(format) + " support is not built in");
+        }
+    }
+}
+
+CompressionFormat Compression::detect(const char *data, size_t size)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    if (size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b)
+    {
+        return CompressionFormat::GZIP;
+    }
+    if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd)
+    {
+        return CompressionFormat::ZSTD;
+    }
+    return CompressionFormat::NONE;
+}
+
+CompressionFormat Compression::forOutput(const std::string &path)
+{
+    if (endsWith(path, ".gz"))
+    {
+        return CompressionFormat::GZIP;
+    }
+    if (endsWith(path, ".zst"))
+    {
+        return CompressionFormat::ZSTD;
+    }
+
+    char magic[4];
+    std::ifstream file(path, std::ios::binary);
+    file.read(magic, sizeof(magic));
+    return detect(magic, static_cast<size_t>(file.gcount()));
+}
+
+std::string Compression::name(CompressionFormat format)
+{
+    switch (format)
+    {
+    case CompressionFormat::GZIP:
+        return "gzip";
+    case CompressionFormat::ZSTD:
+        return "zstd";
+    default:
+        return "none";
+    }
+}
+
+bool Compression::isSupported(CompressionFormat format)
+{
+    switch (format)
+    {
+    case CompressionFormat::GZIP:
+        return JSON_PARSER_GZIP;
+    case CompressionFormat::ZSTD:
+        return JSON_PARSER_ZSTD;
+    default:
+        return true;
+    }
+}
+
+struct Decompressor::State
+{
+#if JSON_PARSER_GZIP
+    z_stream gzip{};
+#endif
+#if JSON_PARSER_ZSTD
+    ZSTD_DStream *zstd = nullptr;
+#endif
+    // true while a gzip member or zstd frame has been started but not ended
+    bool inside = false;
+};
+
+Decompressor::Decompressor(CompressionFormat format) : format(format), state(new State())
+{
+    requireSupport(format);
+#if JSON_PARSER_GZIP
+    if (format == CompressionFormat::GZIP && inflateInit2(&state->gzip, 15 + 16) != Z_OK)
+    {
+        throw std::runtime_error("Could not start gzip decompression");
+    }
+#endif
+#if JSON_PARSER_ZSTD
+    if (format == CompressionFormat::ZSTD)
+    {
+        state->zstd = ZSTD_createDStream();
+        if (!state->zstd || ZSTD_isError(ZSTD_initDStream(state->zstd)))
+        {
+            ZSTD_freeDStream(state->zstd);
+            throw std::runtime_error("Could not start zstd decompression");
+        }
+    }
+#endif
+}
+
+Decompressor::~Decompressor()
+{
+#if JSON_PARSER_GZIP
+    if (format == CompressionFormat::GZIP)
+    {
+        inflateEnd(&state->gzip);
+    }
+#endif
+#if JSON_PARSER_ZSTD
+    if (format == CompressionFormat::ZSTD)
+    {
+        ZSTD_freeDStream(state->zstd);
+    }
+#endif
+}
+
+void Decompressor::feed(const char *data, size_t size, std::string &out)
+{
+#if JSON_PARSER_GZIP
+    if (format == CompressionFormat::GZIP)
+    {
+        z_stream &stream = state->gzip;
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream.avail_in = static_cast<uInt>(size);
+
+        // Output may be held back when the buffer fills up, so go on until
+        // the input is used up and the buffer is no longer filled.
+        do
+        {
+            size_t used = out.size();
+            out.resize(used + OUTPUT_STEP);
+            stream.next_out = reinterpret_cast<Bytef *>(&out[used]);
+            stream.avail_out = static_cast<uInt>(OUTPUT_STEP);
+
+            if (stream.avail_in > 0)
+            {
+                state->inside = true;
+            }
+            int result = inflate(&stream, Z_NO_FLUSH);
+            out.resize(used + OUTPUT_STEP - stream.avail_out);
+
+            if (result == Z_STREAM_END)
+            {
+                // Another member may follow.
+                state->inside = false;
+                inflateReset(&stream);
+            }
+            else if (result == Z_BUF_ERROR)
+            {
+                break;
+            }
+            else if (result != Z_OK)
+            {
+                throw std::runtime_error("Corrupt gzip data");
+            }
+        } while (stream.avail_in > 0 || stream.avail_out == 0);
+        return;
+    }
+#endif
+#if JSON_PARSER_ZSTD
+    if (format == CompressionFormat::ZSTD)
+    {
+        ZSTD_inBuffer input{data, size, 0};
+        bool full;
+        do
+        {
+            size_t used = out.size();
+            out.resize(used + OUTPUT_STEP);
+            ZSTD_outBuffer output{&out[used], OUTPUT_STEP, 0};
+
+            size_t result = ZSTD_decompressStream(state->zstd, &output, &input);
+            out.resize(used + output.pos);
+            if (ZSTD_isError(result))
+            {
+                throw std::runtime_error(std::string("Corrupt zstd data: ") + ZSTD_getErrorName(result));
+            }
+            state->inside = result != 0;
+            full = output.pos == output.size;
+        } while (input.pos < input.size || full);
+        return;
+    }
+#endif
+    (void)data;
+    (void)size;
+    (void)out;
+}
+
+void Decompressor::finish()
+{
+    if (state->inside)
+    {
+        throw std::runtime_error("Truncated " + Compression::name(format) + " data");
+    }
+}
+
+struct Compressor::State
+{
+#if JSON_PARSER_GZIP
+    z_stream gzip{};
+#endif
+#if JSON_PARSER_ZSTD
+    ZSTD_CCtx *zstd = nullptr;
+#endif
+};
+
+Compressor::Compressor(CompressionFormat format) : format(format), state(new State())
+{
+    requireSupport(format);
+#if JSON_PARSER_GZIP
+    if (format == CompressionFormat::GZIP &&
+        deflateInit2(&state->gzip, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        throw std::runtime_error("Could not start gzip compression");
+    }
+#endif
+#if JSON_PARSER_ZSTD
+    if (format == CompressionFormat::ZSTD)
+    {
+        state->zstd = ZSTD_createCCtx();
+        if (!state->zstd)
+        {
+            throw std::runtime_error("Could not start zstd compression");
+        }
+    }
+#endif
+}
+
+Compressor::~Compressor()
+{
+#if JSON_PARSER_GZIP
+    if (format == CompressionFormat::GZIP)
+    {
+        deflateEnd(&state->gzip);
+    }
+#endif
+#if JSON_PARSER_ZSTD
+    if (format == CompressionFormat::ZSTD)
+    {
+        ZSTD_freeCCtx(state->zstd);
+    }
+#endif
+}
+
+void Compressor::feed(const char *data, size_t size, std::string &out)
+{
+#if JSON_PARSER_GZIP
+    if (format == CompressionFormat::GZIP)
+    {
+        z_stream &stream = state->gzip;
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream.avail_in = static_cast<uInt>(size);
+
+        do
+        {
+            size_t used = out.size();
+            out.resize(used + OUTPUT_STEP);
+            stream.next_out = reinterpret_cast<Bytef *>(&out[used]);
+            stream.avail_out = static_cast<uInt>(OUTPUT_STEP);
+            deflate(&stream, Z_NO_FLUSH);
+            out.resize(used + OUTPUT_STEP - stream.avail_out);
+        } while (stream.avail_out == 0);
+        return;
+    }
+#endif
+#if JSON_PARSER_ZSTD
+    if (format == CompressionFormat::ZSTD)
+    {
+        ZSTD_inBuffer input{data, size, 0};
+        while (input.pos < input.size)
+        {
+            size_t used = out.size();
+            out.resize(used + OUTPUT_STEP);
+            ZSTD_outBuffer output{&out[used], OUTPUT_STEP, 0};
+            size_t result = ZSTD_compressStream2(state->zstd, &output, &input, ZSTD_e_continue);
+            out.resize(used + output.pos);
+            if (ZSTD_isError(result))
+            {
+                throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(result));
+            }
+        }
+        return;
+    }
+#endif
+    (void)data;
+    (void)size;
+    (void)out;
+}
+
+void Compressor::finish(std::string &out)
+{
+#if JSON_PARSER_GZIP
+    if (format == CompressionFormat::GZIP)
+    {
+        z_stream &stream = state->gzip;
+        stream.avail_in = 0;
+        int result;
+        do
+        {
+            size_t used = out.size();
+            out.resize(used + OUTPUT_STEP);
+            stream.next_out = reinterpret_cast<Bytef *>(&out[used]);
+            stream.avail_out = static_cast<uInt>(OUTPUT_STEP);
+            result = deflate(&stream, Z_FINISH);
+            out.resize(used + OUTPUT_STEP - stream.avail_out);
+        } while (result == Z_OK);
+        return;
+    }
+#endif
+#if JSON_PARSER_ZSTD
+    if (format == CompressionFormat::ZSTD)
+    {
+        ZSTD_inBuffer input{nullptr, 0, 0};
+        size_t remaining;
+        do
+        {
+            size_t used = out.size();
+            out.resize(used + OUTPUT_STEP);
+            ZSTD_outBuffer output{&out[used], OUTPUT_STEP, 0};
+            remaining = ZSTD_compressStream2(state->zstd, &output, &input, ZSTD_e_end);
+            out.resize(used + output.pos);
+            if (ZSTD_isError(remaining))
+            {
+                throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(remaining));
+            }
+        } while (remaining != 0);
+        return;
+    }
+#endif
+    (void)out;
+}
+
+CompressingBuffer::CompressingBuffer(std::streambuf *target, CompressionFormat format)
+    : target(target), compressor(format), buffer(OUTPUT_STEP, '\0')
+{
+    setp(&buffer[0], &buffer[0] + buffer.size());
+}
+
+bool CompressingBuffer::finish()
+{
+    drain();
+    compressed.clear();
+    compressor.finish(compressed);
+    std::streamsize size = static_cast<std::streamsize>(compressed.size());
+    if (target->sputn(compressed.data(), size) != size)
+    {
+        failed = true;
+    }
+    return !failed;
+}
+
+int CompressingBuffer::overflow(int c)
+{
+    if (!drain())
+    {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int CompressingBuffer::sync()
+{
+    return drain() ? 0 : -1;
+}
+
+bool CompressingBuffer::drain()
+{
+    compressed.clear();
+    compressor.feed(pbase(), static_cast<size_t>(pptr() - pbase()), compressed);
+    setp(&buffer[0], &buffer[0] + buffer.size());
+
+    std::streamsize size = static_cast<std::streamsize>(compressed.size());
+    if (target->sputn(compressed.data(), size) != size)
+    {
+        failed = true;
+    }
+    return !failed;
+}
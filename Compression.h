@@ -0,0 +1,172 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <memory>
+#include <streambuf>
+#include <string>
+
+/**
+ * Enum representing how a file is compressed.
+ */
+enum class CompressionFormat
+{
+    NONE,
+    GZIP,
+    ZSTD
+};
+
+/**
+ * Recognises compressed data. Which formats can actually be read and
+ * written depends on the libraries found when the parser was built.
+ */
+class Compression
+{
+public:
+    /**
+     * Recognises the format of data by its magic bytes.
+     *
+     * @param data the first bytes of the data
+     * @param size number of bytes given; at least 4 to recognise every format
+     *
+     * @return the format, NONE if the data is not compressed
+     */
+    static CompressionFormat detect(const char *data, size_t size);
+
+    /**
+     * Chooses the format to write a file in: by its extension, .gz or .zst,
+     * or else the format the existing file is in.
+     *
+     * @param path path to the file
+     *
+     * @return the format, NONE for plain JSON
+     */
+    static CompressionFormat forOutput(const std::string &path);
+
+    /**
+     * Returns the name of a format.
+     */
+    static std::string name(CompressionFormat format);
+
+    /**
+     * Returns true if this build can read and write a format.
+     */
+    static bool isSupported(CompressionFormat format);
+};
+
+/**
+ * Decompresses a stream of gzip or zstd data given in chunks of any size.
+ * Concatenated gzip members and zstd frames are decoded one after the other.
+ */
+class Decompressor
+{
+public:
+    /**
+     * @throws {std::runtime_error} if the format is not supported by this build
+     */
+    Decompressor(CompressionFormat format);
+    ~Decompressor();
+
+    Decompressor(const Decompressor &) = delete;
+    Decompressor &operator=(const Decompressor &) = delete;
+
+    /**
+     * Decompresses the next chunk of compressed data.
+     *
+     * @param data the compressed bytes
+     * @param size number of compressed bytes
+     * @param out the decompressed bytes are appended to it
+     *
+     * @throws {std::runtime_error} if the data is corrupt
+     */
+    void feed(const char *data, size_t size, std::string &out);
+
+    /**
+     * Checks that the compressed data ended where a member or frame ends.
+     *
+     * @throws {std::runtime_error} if the data is truncated
+     */
+    void finish();
+
+private:
+    struct State;
+
+    CompressionFormat format;
+    std::unique_ptr<State> state;
+};
+
+/**
+ * Compresses a stream of data given in chunks of any size into gzip or zstd.
+ */
+class Compressor
+{
+public:
+    /**
+     * @throws {std::runtime_error} if the format is not supported by this build
+     */
+    Compressor(CompressionFormat format);
+    ~Compressor();
+
+    Compressor(const Compressor &) = delete;
+    Compressor &operator=(const Compressor &) = delete;
+
+    /**
+     * Compresses the next chunk of data.
+     *
+     * @param data the bytes to compress
+     * @param size number of bytes
+     * @param out the compressed bytes are appended to it
+     */
+    void feed(const char *data, size_t size, std::string &out);
+
+    /**
+     * Ends the compressed stream.
+     *
+     * @param out the remaining compressed bytes are appended to it
+     */
+    void finish(std::string &out);
+
+private:
+    struct State;
+
+    CompressionFormat format;
+    std::unique_ptr<State> state;
+};
+
+/**
+ * Stream buffer that compresses everything written to it into another stream buffer.
+ */
+class CompressingBuffer : public std::streambuf
+{
+public:
+    /**
+     * @param target the stream buffer receiving the compressed bytes
+     * @param format the format to compress into
+     */
+    CompressingBuffer(std::streambuf *target, CompressionFormat format);
+
+    /**
+     * Compresses what is still buffered and ends the compressed stream.
+     *
+     * @return false if the compressed bytes could not all be written
+     */
+    bool finish();
+
+protected:
+    int overflow(int c) override;
+    int sync() override;
+
+private:
+    /**
+     * Compresses the buffered bytes and writes the result to the target.
+     */
+    bool drain();
+
+private:
+    std::streambuf *target;
+    Compressor compressor;
+    std::string buffer;
+    std::string compressed;
+    bool failed = false;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "Differ.h"
+#include "JSONPointer.h"
+#include "Printer.h"
+
+#include <algorithm>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+    bool isContainer(const JSONValue *value)
+    {
+        return value->getType() == JSONValueType::OBJECT || value->getType() == JSONValueType::ARRAY;
+    }
+}
+
+size_t Differ::diff(const JSONValue *from, const JSONValue *to, std::ostream &out)
+{
+    JSON_STATS_PHASE(Phase::SEARCH);
+
+    Differ differ;
+    differ.out = &out;
+    out << "[";
+
+    differ.pending.push_back({from, to, ""});
+    while (!differ.pending.empty())
+    {
+        Pending next = std::move(differ.pending.back());
+        differ.pending.pop_back();
+        differ.compare(next.from, next.to, next.path);
+    }
+
+    out << (differ.operations > 0 ? "\n]" : "]");
+    JSON_STATS_PUBLISH(differ.stats);
+    return differ.operations;
+}
+
+void Differ::compare(const JSONValue *from, const JSONValue *to, const std::string &path)
+{
+    JSON_STATS_ADD(stats, nodesVisited, 1);
+    if (from->hash() == to->hash())
+    {
+        return;
+    }
+
+    if (from->getType() != to->getType() || !isContainer(from))
+    {
+        write("replace", path, to);
+    }
+    else if (from->getType() == JSONValueType::OBJECT)
+    {
+        compareObjects(static_cast<const JSONObject *>(from), static_cast<const JSONObject *>(to), path);
+    }
+    else
+    {
+        compareArrays(static_cast<const JSONArray *>(from), static_cast<const JSONArray *>(to), path);
+    }
+}
+
+void Differ::compareObjects(const JSONObject *from, const JSONObject *to, const std::string &path)
+{
+    std::unordered_map<std::string_view, const JSONValue *> fromMembers;
+    std::unordered_map<std::string_view, const JSONValue *> toMembers;
+    fromMembers.reserve(from->getValues().size());
+    toMembers.reserve(to->getValues().size());
+    for (const KeyValue &keyValue : to->getValues())
+    {
+        toMembers.emplace(keyValue.key, keyValue.value.get());
+    }
+
+    std::vector<Pending> changed;
+    for (const KeyValue &keyValue : from->getValues())
+    {
+        if (!fromMembers.emplace(keyValue.key, keyValue.value.get()).second)
+        {
+            continue;
+        }
+
+        std::string memberPath = path;
+        JSONPointer::append(memberPath, keyValue.key);
+        auto found = toMembers.find(keyValue.key);
+        if (found == toMembers.end())
+        {
+            write("remove", memberPath, nullptr);
+        }
+        else
+        {
+            changed.push_back({keyValue.value.get(), found->second, std::move(memberPath)});
+        }
+    }
+
+    for (const KeyValue &keyValue : to->getValues())
+    {
+        if (fromMembers.find(keyValue.key) == fromMembers.end() && toMembers[keyValue.key] == keyValue.value.get())
+        {
+            std::string memberPath = path;
+            JSONPointer::append(memberPath, keyValue.key);
+            write("add", memberPath, keyValue.value.get());
+        }
+    }
+
+    // Pending pairs are taken from the back; push them reversed to keep document order.
+    pending.insert(pending.end(), std::make_move_iterator(changed.rbegin()), std::make_move_iterator(changed.rend()));
+}
+
+void Differ::compareArrays(const JSONArray *from, const JSONArray *to, const std::string &path)
+{
+    const auto &a = from->getValues();
+    const auto &b = to->getValues();
+
+    size_t prefix = 0;
+    while (prefix < a.size() && prefix < b.size() && a[prefix]->hash() == b[prefix]->hash())
+    {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < a.size() - prefix && suffix < b.size() - prefix &&
+           a[a.size() - 1 - suffix]->hash() == b[b.size() - 1 - suffix]->hash())
+    {
+        suffix++;
+    }
+
+    // Between the common ends, an element found only on the from side is
+    // removed and one found only on the to side is added; the others are
+    // paired in order and compared. Counting what is left on each side
+    // makes this linear in the length of the range.
+    std::unordered_map<uint64_t, size_t> fromLeft;
+    std::unordered_map<uint64_t, size_t> toLeft;
+    for (size_t i = prefix; i < a.size() - suffix; i++)
+    {
+        fromLeft[a[i]->hash()]++;
+    }
+    for (size_t j = prefix; j < b.size() - suffix; j++)
+    {
+        toLeft[b[j]->hash()]++;
+    }
+
+    std::vector<Pending> changed;
+    size_t i = prefix;
+    size_t j = prefix;
+    while (i < a.size() - suffix || j < b.size() - suffix)
+    {
+        bool fromDone = i == a.size() - suffix;
+        bool toDone = j == b.size() - suffix;
+        uint64_t fromHash = fromDone ? 0 : a[i]->hash();
+        uint64_t toHash = toDone ? 0 : b[j]->hash();
+
+        if (!fromDone && !toDone && fromHash != toHash)
+        {
+            bool fromKept = toLeft[fromHash] > 0;
+            bool toKept = fromLeft[toHash] > 0;
+            if (fromKept != toKept)
+            {
+                // Keep the element that has a match further on, and add or remove the other.
+                fromDone = fromKept;
+                toDone = toKept;
+            }
+        }
+
+        // Operations are counted in positions of the array as it is at that point, which is j.
+        if (toDone)
+        {
+            write("remove", path + "/" + std::to_string(j), nullptr);
+            fromLeft[fromHash]--;
+            i++;
+            continue;
+        }
+        if (fromDone)
+        {
+            write("add", path + "/" + std::to_string(j), b[j].get());
+            toLeft[toHash]--;
+            j++;
+            continue;
+        }
+
+        if (fromHash != toHash)
+        {
+            changed.push_back({a[i].get(), b[j].get(), path + "/" + std::to_string(j)});
+        }
+        fromLeft[fromHash]--;
+        toLeft[toHash]--;
+        i++;
+        j++;
+    }
+
+    pending.insert(pending.end(), std::make_move_iterator(changed.rbegin()), std::make_move_iterator(changed.rend()));
+}
+
+void Differ::write(const char *op, const std::string &path, const JSONValue *value)
+{
+    *out << (operations++ > 0 ? ",\n" : "\n") << "  {\"op\": \"" << op << "\", \"path\": ";
+    StringCodec::writeQuoted(*out, path);
+    if (value)
+    {
+        *out << ", \"value\": ";
+        Printer::write(*out, value, 2);
+    }
+    *out << "}";
+}
@@ -0,0 +1,79 @@
+#ifndef DIFFER_H
+#define DIFFER_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "JSONObject.h"
+#include "JSONArray.h"
+#include "Stats.h"
+
+/**
+ * Computes the differences between two JSON values as a JSON Patch (RFC 6902).
+ *
+ * The two trees are walked together from the root, and a pair of subtrees
+ * with the same hash (see JSONValue::hash) is taken to be identical and
+ * skipped without looking inside. Hashes are cached on the containers, so
+ * diffing two nearly identical documents costs at most one hashing pass
+ * over each plus work proportional to the changes, and diffing a document
+ * again after an edit rehashes only the containers on the edited path.
+ *
+ * Objects are compared as unordered sets of keys. In arrays, elements
+ * found on one side only are removed or added and the others are compared
+ * in order, so an insertion or removal in the middle of an array becomes a
+ * single add or remove rather than a change of every element after it.
+ */
+class Differ
+{
+public:
+    /**
+     * Writes the patch that turns one value into another.
+     *
+     * @param from the value the patch applies to
+     * @param to the value the patch produces
+     * @param out the stream to write the patch to, as a JSON array of operations
+     *
+     * @return the number of operations written
+     */
+    static size_t diff(const JSONValue *from, const JSONValue *to, std::ostream &out);
+
+private:
+    Differ() = default;
+
+    /**
+     * Writes the operations for a pair of values with different hashes,
+     * and queues the pairs of members that have to be compared in turn.
+     */
+    void compare(const JSONValue *from, const JSONValue *to, const std::string &path);
+
+    void compareObjects(const JSONObject *from, const JSONObject *to, const std::string &path);
+    void compareArrays(const JSONArray *from, const JSONArray *to, const std::string &path);
+
+    /**
+     * Writes one operation.
+     *
+     * @param op the name of the operation
+     * @param path JSON Pointer to the location it applies to
+     * @param value the value it adds or replaces with, nullptr for a removal
+     */
+    void write(const char *op, const std::string &path, const JSONValue *value);
+
+private:
+    /**
+     * A pair of values still to be compared.
+     */
+    struct Pending
+    {
+        const JSONValue *from;
+        const JSONValue *to;
+        std::string path;
+    };
+
+    std::ostream *out = nullptr;
+    size_t operations = 0;
+    std::vector<Pending> pending;
+    StatCounters stats;
+};
+
+#endif
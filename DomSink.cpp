@@ -0,0 +1,134 @@
+#include "DomSink.h"
+
+#include <charconv>
+#include <stdexcept>
+
+DomSink::DomSink(StatCounters &stats) : stats(stats) {}
+
+void DomSink::startObject(size_t offset)
+{
+    JSON_STATS_ADD(stats, nodesAllocated, 1);
+    JSON_STATS_ADD(stats, bytesAllocated, sizeof(JSONObject));
+    stack.emplace_back(std::unique_ptr<JSONValue>(new JSONObject()), offset);
+}
+
+void DomSink::endObject(size_t end)
+{
+    endContainer(end);
+}
+
+void DomSink::startArray(size_t offset)
+{
+    JSON_STATS_ADD(stats, nodesAllocated, 1);
+    JSON_STATS_ADD(stats, bytesAllocated, sizeof(JSONArray));
+    stack.emplace_back(std::unique_ptr<JSONValue>(new JSONArray()), offset);
+}
+
+void DomSink::endArray(size_t end)
+{
+    endContainer(end);
+}
+
+void DomSink::key(std::string_view key)
+{
+    stack.back().key.assign(key.data(), key.size());
+    stack.back().keys.add(KeyFilter::hashKey(key));
+}
+
+void DomSink::string(std::string_view value)
+{
+    JSON_STATS_ADD(stats, nodesAllocated, 1);
+    JSON_STATS_ADD(stats, bytesAllocated, sizeof(JSONString) + value.size());
+    add(std::unique_ptr<JSONValue>(new JSONString(std::string(value))));
+}
+
+void DomSink::number(std::string_view text)
+{
+    // The scanner has checked the grammar; this only fails when the value is out of range.
+    double value = 0;
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc())
+    {
+        throw std::runtime_error("Invalid number '" + std::string(text) + "'");
+    }
+
+    JSON_STATS_ADD(stats, nodesAllocated, 1);
+    JSON_STATS_ADD(stats, bytesAllocated, sizeof(JSONNumber));
+    add(std::unique_ptr<JSONValue>(new JSONNumber(value)));
+}
+
+void DomSink::boolean(bool value)
+{
+    JSON_STATS_ADD(stats, nodesAllocated, 1);
+    JSON_STATS_ADD(stats, bytesAllocated, sizeof(JSONBool));
+    add(std::unique_ptr<JSONValue>(new JSONBool(value)));
+}
+
+void DomSink::null()
+{
+    JSON_STATS_ADD(stats, nodesAllocated, 1);
+    JSON_STATS_ADD(stats, bytesAllocated, sizeof(JSONNull));
+    add(std::unique_ptr<JSONValue>(new JSONNull()));
+}
+
+std::unique_ptr<JSONValue> DomSink::takeRoot()
+{
+    return std::move(root);
+}
+
+void DomSink::reset()
+{
+    stack.clear();
+    root.reset();
+}
+
+void DomSink::endContainer(size_t end)
+{
+    std::unique_ptr<JSONValue> value = std::move(stack.back().container);
+    size_t begin = stack.back().begin;
+    KeyFilter keys = stack.back().keys;
+    size_t nodes = stack.back().nodes;
+    stack.pop_back();
+
+    value->setKeyFilter(keys, nodes);
+    if (!stack.empty())
+    {
+        stack.back().keys.merge(keys);
+        stack.back().nodes += nodes;
+    }
+
+    size_t parentBegin = stack.empty() ? 0 : stack.back().begin;
+    SourceSpan span{begin - parentBegin, end - begin};
+    if (value->getType() == JSONValueType::OBJECT)
+    {
+        static_cast<JSONObject *>(value.get())->setSourceSpan(span);
+    }
+    else
+    {
+        static_cast<JSONArray *>(value.get())->setSourceSpan(span);
+    }
+
+    add(std::move(value));
+}
+
+void DomSink::add(std::unique_ptr<JSONValue> value)
+{
+    if (stack.empty())
+    {
+        root = std::move(value);
+        return;
+    }
+
+    Frame &frame = stack.back();
+    frame.nodes++;
+    if (frame.container->getType() == JSONValueType::OBJECT)
+    {
+        JSON_STATS_ADD(stats, bytesAllocated, sizeof(KeyValue) + frame.key.size());
+        static_cast<JSONObject *>(frame.container.get())->appendValue(frame.key, std::move(value));
+    }
+    else
+    {
+        JSON_STATS_ADD(stats, bytesAllocated, sizeof(JSONValue *));
+        static_cast<JSONArray *>(frame.container.get())->appendValue(std::move(value));
+    }
+}
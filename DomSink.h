@@ -0,0 +1,92 @@
+#ifndef DOM_SINK_H
+#define DOM_SINK_H
+
+#include <string_view>
+
+#include "JSONObject.h"
+#include "JSONArray.h"
+#include "JSONString.h"
+#include "JSONNumber.h"
+#include "JSONBool.h"
+#include "JSONNull.h"
+#include "KeyFilter.h"
+#include "Stats.h"
+
+/**
+ * Sink for BasicParser that builds a tree of JSONValue objects and records
+ * the source span and key filter of every object and array.
+ */
+class DomSink
+{
+public:
+    /**
+     * Creates a sink that builds a new tree.
+     *
+     * @param stats counters to record the allocated nodes in
+     */
+    DomSink(StatCounters &stats);
+
+    void startObject(size_t offset);
+    void endObject(size_t end);
+    void startArray(size_t offset);
+    void endArray(size_t end);
+    void key(std::string_view key);
+    void string(std::string_view value);
+    void number(std::string_view text);
+    void boolean(bool value);
+    void null();
+
+    /**
+     * Hands the finished tree to the caller.
+     *
+     * @return the root JSONValue, or nullptr if nothing has been parsed
+     */
+    std::unique_ptr<JSONValue> takeRoot();
+
+    /**
+     * Frees anything built so far, such as the part of a tree left by a
+     * failed parse, so that the sink can build another tree. The storage
+     * of its stack is kept.
+     */
+    void reset();
+
+private:
+    /**
+     * An object or array whose members are still being parsed, with the key
+     * of the member being parsed when it is an object, and the keys and
+     * number of values parsed below it so far.
+     */
+    struct Frame
+    {
+        std::unique_ptr<JSONValue> container;
+        std::string key;
+        size_t begin;
+        KeyFilter keys;
+        size_t nodes = 0;
+
+        Frame(std::unique_ptr<JSONValue> container, size_t begin) : container(std::move(container)), begin(begin) {}
+    };
+
+    /**
+     * Pops a finished object or array off the stack, records its source span
+     * and key filter and attaches it to its parent.
+     *
+     * @param end offset just past the closing bracket
+     */
+    void endContainer(size_t end);
+
+    /**
+     * Attaches a finished value to the open container, or makes it the root.
+     *
+     * @param value the finished value
+     */
+    void add(std::unique_ptr<JSONValue> value);
+
+private:
+    // Should parsing fail, the stack owns everything built so far and frees it.
+    std::vector<Frame> stack;
+    std::unique_ptr<JSONValue> root;
+    StatCounters &stats;
+};
+
+#endif
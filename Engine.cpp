@@ -1,40 +1,154 @@
 #include "Engine.h"
 
-Engine::Engine() {}
+namespace
+{
+    /**
+     * Reads and compiles a JSON Schema file, reporting why if it cannot.
+     *
+     * @param err the stream to report to
+     * @return the schema, or nullptr if the file cannot be read or is not a supported schema
+     */
+    std::unique_ptr<Schema> loadSchema(const std::string &path, size_t maxDepth, std::ostream &err)
+    {
+        try
+        {
+            std::unique_ptr<JSONValue> document = Parser::parseFile(path, maxDepth);
+            return std::unique_ptr<Schema>(new Schema(document.get()));
+        }
+        catch (const std::exception &e)
+        {
+            err << "Error loading schema: " << e.what() << std::endl;
+            return nullptr;
+        }
+    }
+
+    /**
+     * Reads a non-negative number given as a command argument.
+     *
+     * @param text the argument
+     * @param value receives the number
+     *
+     * @return false if the argument is not a number or does not fit in a size_t
+     */
+    bool parseCount(const std::string &text, size_t &value)
+    {
+        if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+
+        try
+        {
+            value = std::stoul(text);
+        }
+        catch (const std::out_of_range &)
+        {
+            return false;
+        }
+        return true;
+    }
+}
+
+Engine::Engine() : workspace(std::make_shared<Workspace>()), saver(std::make_shared<Saver>(*workspace)) {}
+
+Engine::Engine(std::shared_ptr<Workspace> workspace, std::shared_ptr<Saver> saver)
+    : workspace(std::move(workspace)), saver(std::move(saver))
+{
+}
+
+Engine::~Engine()
+{
+    // Results are handed out by owner, so this engine's must be collected before it goes.
+    saver->flush();
+    reportSaves();
+}
 
 void Engine::prompt()
 {
     if (!fileLoaded)
     {
-        std::cout << "Please enter the path of the json file you wish to manipulate." << std::endl;
+        *out << "Please enter the path of the json file you wish to manipulate." << std::endl;
         std::string filePath;
         std::getline(std::cin, filePath);
         openFile(filePath);
     }
 
-    std::cout << "------------------------------------------------------------------------------" << std::endl;
-    std::cout << "Welcome! Pick any of the following commands to operate with the JSON Parser: " << std::endl;
-    std::cout << "------------------------------------------------------------------------------" << std::endl;
-    std::cout << "open <path> | validate | print | search <key> | " << std::endl;
-    std::cout << "contains <value> | set <path> <string> | create <path> <string> | " << std::endl;
-    std::cout << "delete <path> | move <from> <to> | save [<path>] | saveas <file> [<path>]" << std::endl;
-    std::cout << "------------------------------------------------------------------------------" << std::endl;
+    *out << "------------------------------------------------------------------------------" << std::endl;
+    *out << "Welcome! Pick any of the following commands to operate with the JSON Parser: " << std::endl;
+    *out << "------------------------------------------------------------------------------" << std::endl;
+    *out << "open <path> | validate | validate-schema <schema> | validate-all <dir|glob> [--schema <schema>]" << std::endl;
+    *out << "print [<path>] [--depth N] [--limit K] [--offset M] | search <key> [--limit N] | contains <value>" << std::endl;
+    *out << "set <path> <string> | create <path> <string> | delete <path> | move <from> <to>" << std::endl;
+    *out << "save [<path>] | saveas <file> [<path>] | export <file> [<path>] | rename <path> <key> | undo | redo" << std::endl;
+    *out << "stats [reset | json [on | off]] | memory | depth <limit> | workspace [budget <MB>] | sync" << std::endl;
+    *out << "get <file> <path> | diff <file> | patch <file>" << std::endl;
+    *out << "------------------------------------------------------------------------------" << std::endl;
 
     std::string command;
     while (true)
     {
-        std::cout << "\n[" << currentFilePath << "] " << "> ";
+        *out << "\n[" << currentFilePath << "] " << "> ";
         std::getline(std::cin, command);
         if (command == "exit")
         {
             break;
         }
+        try
+        {
+            executeCommand(command);
+        }
+        catch (const std::exception &e)
+        {
+            *err << "Error: " << e.what() << std::endl;
+        }
+
+        if (statsAfterCommand)
+        {
+            Stats::writeJSON(*out);
+        }
+    }
+}
+
+void Engine::execute(const std::string &command, std::ostream &stream)
+{
+    out = &stream;
+    err = &stream;
+
+    try
+    {
         executeCommand(command);
     }
+    catch (const std::exception &e)
+    {
+        *err << "Error: " << e.what() << std::endl;
+    }
+
+    if (statsAfterCommand)
+    {
+        Stats::writeJSON(*out);
+    }
+
+    out = &*out;
+    err = &*err;
 }
 
 void Engine::executeCommand(const std::string &command)
 {
+    bool needsFile = command.rfind("open ", 0) != 0 && command.rfind("depth ", 0) != 0 && command.rfind("stats", 0) != 0 &&
+                     command.rfind("workspace", 0) != 0 && command != "sync" &&
+                     command.rfind("validate-all ", 0) != 0 && command.rfind("get ", 0) != 0;
+    if (!parser && needsFile)
+    {
+        *err << "No JSON file is loaded. Use open <path> first." << std::endl;
+        return;
+    }
+
+    reportSaves();
+    if (parser && command.rfind("open ", 0) != 0)
+    {
+        reloadIfChanged();
+    }
+
     if (command.rfind("open ", 0) == 0)
     {
         std::string filePath = command.substr(5);
@@ -42,34 +156,102 @@ void Engine::executeCommand(const std::string &command)
     }
     else if (command == "validate")
     {
-        std::cout << (parser->validate() ? "Valid JSON file." : "Invalid JSON file.") << std::endl;
+        *out << (parser->validate() ? "Valid JSON file." : "Invalid JSON file.") << std::endl;
+    }
+    else if (command.rfind("validate-schema ", 0) == 0)
+    {
+        std::unique_ptr<Schema> schema = loadSchema(command.substr(16), maxDepth, *err);
+        if (!schema)
+        {
+            return;
+        }
+        std::string error;
+        if (parser->validateSchema(*schema, error))
+        {
+            *out << "Valid JSON file conforming to the schema." << std::endl;
+        }
+        else
+        {
+            *out << "Invalid JSON file: " << error << std::endl;
+        }
     }
     else if (command == "print")
     {
-        parser->print();
+        parser->print(*out);
+    }
+    else if (command.rfind("print ", 0) == 0)
+    {
+        std::istringstream arguments(command.substr(6));
+        std::string path;
+        PrintLimits limits;
+        std::string argument;
+        while (arguments >> argument)
+        {
+            size_t *limit = argument == "--depth" ? &limits.depth
+                            : argument == "--limit" ? &limits.limit
+                            : argument == "--offset" ? &limits.offset
+                                                     : nullptr;
+            if (limit)
+            {
+                std::string number;
+                if (!(arguments >> number) || !parseCount(number, *limit))
+                {
+                    *err << "Invalid command format." << std::endl;
+                    return;
+                }
+            }
+            else if (path.empty() && argument.rfind("--", 0) != 0)
+            {
+                path = argument;
+            }
+            else
+            {
+                *err << "Invalid command format." << std::endl;
+                return;
+            }
+        }
+
+        if (!parser->print(path, limits, *out))
+        {
+            *err << "Path not found: " << path << std::endl;
+            return;
+        }
+        *out << std::endl;
     }
     else if (command.rfind("search ", 0) == 0)
     {
         std::string key = command.substr(7);
-        std::vector<JSONValue *> values = parser->searchKey(key);
-        std::cout << "\"" << key << "\"" << ":" << std::endl;
-        std::cout << "[" << std::endl;
-        for (const auto &value : values)
+        size_t limit = SIZE_MAX;
+        size_t limitPos = key.rfind(" --limit ");
+        if (limitPos != std::string::npos)
+        {
+            if (!parseCount(key.substr(limitPos + 9), limit))
+            {
+                *err << "Invalid command format." << std::endl;
+                return;
+            }
+            key = key.substr(0, limitPos);
+        }
+
+        *out << "\"" << key << "\"" << ":" << std::endl;
+        bool stoppedEarly = false;
+        parser->searchKey(key, *out, limit, &stoppedEarly);
+        *out << std::endl;
+        if (stoppedEarly)
         {
-            std::cout << value->toString() << std::endl;
+            *out << "Stopped after " << limit << (limit == 1 ? " match." : " matches.") << std::endl;
         }
-        std::cout << "]" << std::endl;
     }
     else if (command.rfind("contains ", 0) == 0)
     {
         std::string value = command.substr(9);
         if (parser->contains(value))
         {
-            std::cout << "The value \"" << value << "\" is present in the JSON document." << std::endl;
+            *out << "The value \"" << value << "\" is present in the JSON document." << std::endl;
         }
         else
         {
-            std::cout << "The value \"" << value << "\" is not present in the JSON document." << std::endl;
+            *out << "The value \"" << value << "\" is not present in the JSON document." << std::endl;
         }
     }
     else if (command.rfind("set ", 0) == 0)
@@ -78,22 +260,32 @@ void Engine::executeCommand(const std::string &command)
 
         if (pos == std::string::npos)
         {
-            std::cerr << "Invalid command format." << std::endl;
+            *err << "Invalid command format." << std::endl;
             return;
         }
 
         std::string path = command.substr(4, pos - 4);
         std::string value = command.substr(pos + 1);
 
-        if (parser->set(path, value))
+        bool changed = false;
+        if (!parser->set(path, value, &changed, *err))
         {
-            std::cout << "Successfully updated the value at path: " << path << std::endl;
+            *out << "Failed to update the value at path: " << path << std::endl;
+        }
+        else if (!changed)
+        {
+            *out << "The value at path: " << path << " is unchanged." << std::endl;
         }
         else
         {
-            std::cout << "Failed to update the value at path: " << path << std::endl;
+            *out << "Successfully updated the value at path: " << path << std::endl;
+        }
+
+        // A set that changed nothing leaves the file as it is.
+        if (changed)
+        {
+            writeCurrentFile();
         }
-        parser->writeToFile(currentFilePath);
     }
     else if (command.rfind("create ", 0) == 0)
     {
@@ -101,34 +293,34 @@ void Engine::executeCommand(const std::string &command)
 
         if (pos == std::string::npos)
         {
-            std::cerr << "Invalid command format." << std::endl;
+            *err << "Invalid command format." << std::endl;
             return;
         }
 
         std::string path = command.substr(7, pos - 7);
         std::string value = command.substr(pos + 1);
-        if (parser->create(path, value))
+        if (parser->create(path, value, *err))
         {
-            std::cout << "Successfully created the value at path: " << path << std::endl;
+            *out << "Successfully created the value at path: " << path << std::endl;
         }
         else
         {
-            std::cout << "Failed to create the value at path: " << path << std::endl;
+            *out << "Failed to create the value at path: " << path << std::endl;
         }
-        parser->writeToFile(currentFilePath);
+        writeCurrentFile();
     }
     else if (command.rfind("delete ", 0) == 0)
     {
         std::string path = command.substr(7);
-        if (parser->deleteElement(path))
+        if (parser->deleteElement(path, *err))
         {
-            std::cout << "Successfully deleted the value at path: " << path << std::endl;
+            *out << "Successfully deleted the value at path: " << path << std::endl;
         }
         else
         {
-            std::cout << "Failed to delete the value at path: " << path << std::endl;
+            *out << "Failed to delete the value at path: " << path << std::endl;
         }
-        parser->writeToFile(currentFilePath);
+        writeCurrentFile();
     }
 
     // TODO: fix
@@ -137,81 +329,249 @@ void Engine::executeCommand(const std::string &command)
         size_t pos = command.find(" ", 5);
         if (pos == std::string::npos)
         {
-            std::cerr << "Invalid command format." << std::endl;
+            *err << "Invalid command format." << std::endl;
             return;
         }
         std::string from = command.substr(5, pos - 5);
         std::string to = command.substr(pos + 1);
-        if (parser->move(from, to))
+        if (parser->move(from, to, *err))
         {
-            std::cout << "Successfully moved the value from path: " << from << " to path: " << to << std::endl;
+            *out << "Successfully moved the value from path: " << from << " to path: " << to << std::endl;
         }
         else
         {
-            std::cout << "Failed to move the value from path: " << from << " to path: " << to << std::endl;
+            *out << "Failed to move the value from path: " << from << " to path: " << to << std::endl;
         }
-        parser->writeToFile(currentFilePath);
+        writeCurrentFile();
     }
-    else if (command == "save")
+    else if (command.rfind("rename ", 0) == 0)
     {
-        if (parser->save(currentFilePath))
+        size_t pos = command.find(" ", 7);
+        if (pos == std::string::npos)
         {
-            std::cout << "Successfully saved JSON file " << currentFilePath << std::endl;
+            *err << "Invalid command format." << std::endl;
+            return;
+        }
+        std::string path = command.substr(7, pos - 7);
+        std::string key = command.substr(pos + 1);
+        if (parser->rename(path, key, *err))
+        {
+            *out << "Successfully renamed " << path << " to " << key << std::endl;
         }
         else
         {
-            std::cout << "Failed to save the JSON" << std::endl;
+            *out << "Failed to rename " << path << " to " << key << std::endl;
         }
+        writeCurrentFile();
     }
-    else if (command.rfind("save ", 0) == 0)
+    else if (command.rfind("diff ", 0) == 0)
     {
-        std::string path = command.substr(5);
-        if (parser->save(currentFilePath, "", path))
+        std::string file = command.substr(5);
+        try
         {
-            std::cout << "Successfully saved " << path << " in JSON file " << currentFilePath << std::endl;
+            std::unique_ptr<JSONValue> target = Parser::parseFile(file, maxDepth);
+            parser->diff(target.get(), *out);
+            *out << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            *err << "Could not diff with " << file << ": " << e.what() << std::endl;
+        }
+    }
+    else if (command.rfind("patch ", 0) == 0)
+    {
+        std::string file = command.substr(6);
+        std::unique_ptr<JSONValue> operations;
+        try
+        {
+            operations = Parser::parseFile(file, maxDepth);
+        }
+        catch (const std::exception &e)
+        {
+            *err << "Could not read patch " << file << ": " << e.what() << std::endl;
+            return;
+        }
+
+        if (parser->patch(std::move(operations), "patch " + file, *err))
+        {
+            *out << "Successfully applied the patch " << file << std::endl;
         }
         else
         {
-            std::cout << "Failed to save JSON path " << path << std::endl;
+            *out << "Failed to apply the patch " << file << std::endl;
+        }
+        writeCurrentFile();
+    }
+    else if (command == "undo" || command == "redo")
+    {
+        std::string description = command == "undo" ? parser->undo() : parser->redo();
+        if (description.empty())
+        {
+            *out << "Nothing to " << command << "." << std::endl;
+            return;
         }
+
+        *out << (command == "undo" ? "Undid: " : "Redid: ") << description << std::endl;
+        writeCurrentFile();
+    }
+    else if (command == "save")
+    {
+        saver->save(parser, currentFilePath, "", OutputFormat::PRETTY, this);
+        *out << "Saving JSON file " << currentFilePath << " in the background." << std::endl;
+    }
+    else if (command.rfind("save ", 0) == 0)
+    {
+        std::string path = command.substr(5);
+        saver->save(parser, currentFilePath, path, OutputFormat::PRETTY, this);
+        *out << "Saving " << path << " in JSON file " << currentFilePath << " in the background." << std::endl;
     }
     else if (command.rfind("saveas ", 0) == 0)
     {
         size_t pos = command.find(" ", 7);
         if (pos == std::string::npos)
         {
-            std::cerr << "Invalid command format." << std::endl;
+            *err << "Invalid command format." << std::endl;
             return;
         }
         std::string file = command.substr(7, pos - 7);
         std::string path = command.substr(pos + 1);
 
+        saver->save(parser, file, path, OutputFormat::PRETTY, this);
         if (path.empty())
         {
-            if (parser->saveas(currentFilePath, file, ""))
-            {
-                std::cout << "Successfully saved JSON to " << file << std::endl;
-            }
-            else
-            {
-                std::cout << "Failed to save JSON to " << file << std::endl;
-            }
+            *out << "Saving JSON to " << file << " in the background." << std::endl;
         }
         else
         {
-            if (parser->saveas(currentFilePath, file, path))
-            {
-                std::cout << "Successfully saved the JSON at path: " << path << " to " << file << std::endl;
-            }
-            else
+            *out << "Saving the JSON at path: " << path << " to " << file << " in the background." << std::endl;
+        }
+    }
+    else if (command.rfind("export ", 0) == 0)
+    {
+        size_t pos = command.find(" ", 7);
+        std::string file = command.substr(7, pos == std::string::npos ? std::string::npos : pos - 7);
+        std::string path = pos == std::string::npos ? "" : command.substr(pos + 1);
+
+        saver->save(parser, file, path, OutputFormat::CANONICAL, this);
+        if (path.empty())
+        {
+            *out << "Exporting canonical JSON to " << file << " in the background." << std::endl;
+        }
+        else
+        {
+            *out << "Exporting the JSON at path: " << path << " as canonical JSON to " << file << " in the background." << std::endl;
+        }
+    }
+    else if (command.rfind("validate-all ", 0) == 0)
+    {
+        std::string pattern = command.substr(13);
+        std::unique_ptr<Schema> schema;
+        size_t schemaPos = pattern.find(" --schema ");
+        if (schemaPos != std::string::npos)
+        {
+            // The schema is compiled once and shared by all files.
+            schema = loadSchema(pattern.substr(schemaPos + 10), maxDepth, *err);
+            if (!schema)
             {
-                std::cout << "Failed to save the JSON at path: " << path << " to " << file << std::endl;
+                return;
             }
+            pattern = pattern.substr(0, schemaPos);
+        }
+
+        std::vector<std::string> files = BulkValidator::findFiles(pattern);
+        if (files.empty())
+        {
+            *out << "No files match " << pattern << std::endl;
+            return;
+        }
+        BulkValidator::print(BulkValidator::validateAll(files, 0, maxDepth, schema.get()), *out);
+    }
+    else if (command.rfind("get ", 0) == 0)
+    {
+        size_t pos = command.find(" ", 4);
+        if (pos == std::string::npos)
+        {
+            *err << "Invalid command format." << std::endl;
+            return;
+        }
+
+        std::string file = command.substr(4, pos - 4);
+        std::string path = command.substr(pos + 1);
+        std::unique_ptr<JSONValue> value;
+        try
+        {
+            value = PathExtractor::extract(file, path, maxDepth);
+        }
+        catch (const std::exception &e)
+        {
+            *err << "Error: " << e.what() << std::endl;
+            return;
+        }
+        if (!value)
+        {
+            *err << "Path not found: " << path << std::endl;
+            return;
         }
+        Printer::write(*out, value.get());
+        *out << std::endl;
+    }
+    else if (command == "sync")
+    {
+        saver->flush();
+        reportSaves();
+        *out << "All saves are written." << std::endl;
+    }
+    else if (command.rfind("depth ", 0) == 0)
+    {
+        size_t limit;
+        if (!parseCount(command.substr(6), limit))
+        {
+            *err << "Invalid command format." << std::endl;
+            return;
+        }
+        maxDepth = limit;
+        *out << "Maximum nesting depth set to " << maxDepth << "; it applies to files opened from now on." << std::endl;
+    }
+    else if (command == "workspace")
+    {
+        workspace->print(*out);
+    }
+    else if (command.rfind("workspace budget ", 0) == 0)
+    {
+        size_t megabytes;
+        if (!parseCount(command.substr(17), megabytes) || megabytes > SIZE_MAX / (1024 * 1024))
+        {
+            *err << "Invalid command format." << std::endl;
+            return;
+        }
+        workspace->setMemoryBudget(megabytes * 1024 * 1024);
+        *out << "Workspace memory budget set to " << megabytes << " MB." << std::endl;
+    }
+    else if (command == "memory")
+    {
+        MemoryReport::print(parser->measureMemory(), *out);
+    }
+    else if (command == "stats")
+    {
+        Stats::print(*out);
+    }
+    else if (command == "stats reset")
+    {
+        Stats::reset();
+        *out << "Statistics reset." << std::endl;
+    }
+    else if (command == "stats json")
+    {
+        Stats::writeJSON(*out);
+    }
+    else if (command == "stats json on" || command == "stats json off")
+    {
+        statsAfterCommand = command == "stats json on";
+        *out << "Statistics will " << (statsAfterCommand ? "" : "no longer ") << "be printed after each command." << std::endl;
     }
     else
     {
-        std::cerr << "Unknown command: " << command << std::endl;
+        *err << "Unknown command: " << command << std::endl;
     }
 }
 
@@ -220,33 +580,78 @@ void Engine::openFile(const std::string &filePath)
     std::ifstream file(filePath);
     if (!file.is_open())
     {
-        std::cerr << "File does not exist. Creating a new empty file..." << std::endl;
+        *err << "File does not exist. Creating a new empty file..." << std::endl;
         std::ofstream newFile(filePath);
         newFile << "{}";
         newFile.close();
         file.open(filePath);
         if (!file.is_open())
         {
-            std::cout << "Could not create the file!" << std::endl;
+            *out << "Could not create the file!" << std::endl;
             return;
         }
     }
-
-    std::string input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
     file.close();
 
     try
     {
-        parser = new Parser(input);
+        OpenResult result;
+        parser = workspace->open(filePath, maxDepth, result);
         fileLoaded = true;
         currentFilePath = filePath;
-        std::cout << "Successfully loaded file " << filePath << std::endl;
+        *out << "Successfully loaded file " << filePath;
+        if (result == OpenResult::CACHED)
+        {
+            *out << " (cached)";
+        }
+        else if (result == OpenResult::RELOADED)
+        {
+            *out << " (reloaded changes)";
+        }
+        *out << std::endl;
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Error loading file: " << e.what() << std::endl;
-        fileLoaded = false;
-        delete parser;
-        parser = nullptr;
+        *err << "Error loading file: " << e.what() << std::endl;
+    }
+}
+
+void Engine::reloadIfChanged()
+{
+    // A file with a save in flight changes under us without being edited.
+    if (saver->isPending(currentFilePath) || !workspace->isStale(currentFilePath))
+    {
+        return;
     }
-}
\ No newline at end of file
+
+    try
+    {
+        OpenResult result;
+        parser = workspace->open(currentFilePath, maxDepth, result);
+        if (result == OpenResult::RELOADED)
+        {
+            *out << "Reloaded changes to " << currentFilePath << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        *err << "Could not reload " << currentFilePath << ": " << e.what() << std::endl;
+    }
+}
+
+void Engine::writeCurrentFile()
+{
+    saver->save(parser, currentFilePath, "", OutputFormat::PRETTY, this);
+}
+
+void Engine::reportSaves()
+{
+    for (const SaveResult &result : saver->takeResults(this))
+    {
+        if (!result.success)
+        {
+            *err << "Failed to save " << (result.path.empty() ? "JSON" : result.path) << " to " << result.file
+                 << ": " << result.error << std::endl;
+        }
+    }
+}
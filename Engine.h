@@ -4,32 +4,59 @@
 #include <fstream>
 #include <string>
 
+#include "BulkValidator.h"
 #include "Parser.h"
+#include "PathExtractor.h"
 #include "Searcher.h"
+#include "Saver.h"
+#include "Workspace.h"
 
 /**
  * Class responsible for handling user input and executing commands to manipulate JSON data using the Parser.
+ *
+ * An engine is one session: it has its own current document, depth limit
+ * and output streams. Several engines may share a workspace and a saver, so
+ * that sessions on different threads work on the same parsed documents.
  */
 class Engine
 {
 public:
     /**
-     * Constructs an Engine object.
+     * Constructs an Engine object with a workspace and saver of its own.
      */
     Engine();
 
+    /**
+     * Constructs an Engine object sharing a workspace and saver with other engines.
+     *
+     * @param workspace the shared workspace
+     * @param saver the shared saver; it must report to the shared workspace
+     */
+    Engine(std::shared_ptr<Workspace> workspace, std::shared_ptr<Saver> saver);
+
+    /**
+     * Waits for pending saves and reports the ones that failed.
+     */
+    ~Engine();
+
+    Engine(const Engine &) = delete;
+    Engine &operator=(const Engine &) = delete;
+
     /**
      * Prompts the user for commands and executes them.
      * If no file is loaded, it first prompts the user to enter the path of the JSON file to manipulate.
      */
     void prompt();
 
-private:
     /**
-     * Executes the given command.
-     * @param command The command to execute.
+     * Executes a single command and writes everything it prints, including
+     * errors, to the given stream instead of the standard streams.
+     * Errors thrown by the command are reported rather than propagated.
+     *
+     * @param command the command to execute
+     * @param stream the stream to write the command's output to
      */
-    void executeCommand(const std::string &command);
+    void execute(const std::string &command, std::ostream &stream);
 
     /**
      * Opens the specified file and loads its content into the parser.
@@ -39,9 +66,38 @@ private:
     void openFile(const std::string &filePath);
 
 private:
-    Parser *parser = nullptr;
+    /**
+     * Executes the given command.
+     * @param command The command to execute.
+     */
+    void executeCommand(const std::string &command);
+
+    /**
+     * Brings the current document up to date if its file was changed by another process.
+     */
+    void reloadIfChanged();
+
+    /**
+     * Queues a background save of the current document to its file after a change.
+     */
+    void writeCurrentFile();
+
+    /**
+     * Reports the background saves of this engine that failed.
+     */
+    void reportSaves();
+
+private:
+    std::shared_ptr<Workspace> workspace;
+    std::shared_ptr<Saver> saver;
+    std::shared_ptr<Parser> parser;
+    size_t maxDepth = DEFAULT_MAX_DEPTH;
     bool fileLoaded = false;
+    bool statsAfterCommand = false;
     std::string currentFilePath;
+    // where commands print; the standard streams unless execute was given another
+    std::ostream *out = &std::cout;
+    std::ostream *err = &std::cerr;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "History.h"
+
+EditStep EditStep::insert(JSONObject *parent, const std::string &key, std::unique_ptr<JSONValue> value)
+{
+    return EditStep(EditKind::INSERT, parent, key, std::move(value));
+}
+
+EditStep EditStep::remove(JSONObject *parent, const std::string &key)
+{
+    return EditStep(EditKind::REMOVE, parent, key);
+}
+
+EditStep EditStep::replace(JSONObject *parent, const std::string &key, std::unique_ptr<JSONValue> value)
+{
+    return EditStep(EditKind::REPLACE, parent, key, std::move(value));
+}
+
+EditStep EditStep::move(JSONObject *parent, const std::string &key, JSONObject *targetParent, const std::string &targetKey)
+{
+    EditStep step(EditKind::MOVE, parent, key);
+    step.targetParent = targetParent;
+    step.targetKey = targetKey;
+    return step;
+}
+
+EditStep EditStep::rename(JSONObject *parent, const std::string &key, const std::string &newKey)
+{
+    EditStep step(EditKind::RENAME, parent, key);
+    step.targetKey = newKey;
+    return step;
+}
+
+EditStep EditStep::insertAt(JSONArray *array, size_t index, std::unique_ptr<JSONValue> value)
+{
+    EditStep step(EditKind::INSERT, nullptr, "", std::move(value));
+    step.array = array;
+    step.index = index;
+    return step;
+}
+
+EditStep EditStep::removeAt(JSONArray *array, size_t index)
+{
+    EditStep step(EditKind::REMOVE, nullptr, "");
+    step.array = array;
+    step.index = index;
+    return step;
+}
+
+EditStep EditStep::replaceAt(JSONArray *array, size_t index, std::unique_ptr<JSONValue> value)
+{
+    EditStep step(EditKind::REPLACE, nullptr, "", std::move(value));
+    step.array = array;
+    step.index = index;
+    return step;
+}
+
+EditStep EditStep::replaceRoot(std::unique_ptr<JSONValue> *root, std::unique_ptr<JSONValue> value)
+{
+    EditStep step(EditKind::REPLACE, nullptr, "", std::move(value));
+    step.root = root;
+    return step;
+}
+
+EditStep EditStep::relink(JSONObject *parent, JSONArray *array, const std::string &key, size_t index,
+                          JSONObject *targetParent, JSONArray *targetArray, const std::string &targetKey, size_t targetIndex)
+{
+    EditStep step(EditKind::MOVE, parent, key);
+    step.array = array;
+    step.index = index;
+    step.targetParent = targetParent;
+    step.targetArray = targetArray;
+    step.targetKey = targetKey;
+    step.targetIndex = targetIndex;
+    return step;
+}
+
+History::History(size_t limit) : limit(limit) {}
+
+History::~History()
+{
+    clear();
+}
+
+void History::perform(Edit edit)
+{
+    apply(edit);
+    record(std::move(edit));
+}
+
+void History::record(Edit edit)
+{
+    redoStack.clear();
+
+    undoStack.push_back(std::move(edit));
+    while (undoStack.size() > limit)
+    {
+        undoStack.pop_front();
+    }
+}
+
+std::string History::undo()
+{
+    if (undoStack.empty())
+    {
+        return "";
+    }
+
+    Edit edit = std::move(undoStack.back());
+    undoStack.pop_back();
+    revert(edit);
+    redoStack.push_back(std::move(edit));
+    return redoStack.back().description;
+}
+
+std::string History::redo()
+{
+    if (redoStack.empty())
+    {
+        return "";
+    }
+
+    Edit edit = std::move(redoStack.back());
+    redoStack.pop_back();
+    apply(edit);
+    undoStack.push_back(std::move(edit));
+    return undoStack.back().description;
+}
+
+void History::clear()
+{
+    undoStack.clear();
+    redoStack.clear();
+}
+
+void History::apply(Edit &edit)
+{
+    for (EditStep &step : edit.steps)
+    {
+        applyStep(step);
+    }
+    invalidate(edit);
+}
+
+void History::revert(Edit &edit)
+{
+    for (auto it = edit.steps.rbegin(); it != edit.steps.rend(); ++it)
+    {
+        revertStep(*it);
+    }
+    invalidate(edit);
+}
+
+void History::invalidate(const Edit &edit)
+{
+    for (JSONValue *container : edit.containers)
+    {
+        container->invalidateHash();
+    }
+}
+
+void History::applyStep(EditStep &step)
+{
+    switch (step.kind)
+    {
+    case EditKind::INSERT:
+        if (step.array)
+        {
+            step.array->attachValue(step.index, std::move(step.held));
+            break;
+        }
+        if (step.index == std::string::npos)
+        {
+            step.index = step.parent->getValues().size();
+        }
+        step.parent->attachValue(step.index, step.key, std::move(step.held));
+        break;
+    case EditKind::REMOVE:
+        if (step.array)
+        {
+            step.held = step.array->detachValue(step.index);
+            break;
+        }
+        step.index = step.parent->indexOf(step.key);
+        step.held = step.parent->detachValue(step.key);
+        break;
+    case EditKind::REPLACE:
+        if (step.root)
+        {
+            step.root->swap(step.held);
+            break;
+        }
+        step.held = step.array ? step.array->replaceValue(step.index, std::move(step.held))
+                               : step.parent->replaceValue(step.key, std::move(step.held));
+        break;
+    case EditKind::MOVE:
+    {
+        std::unique_ptr<JSONValue> value;
+        if (step.array)
+        {
+            value = step.array->detachValue(step.index);
+        }
+        else
+        {
+            step.index = step.parent->indexOf(step.key);
+            value = step.parent->detachValue(step.key);
+        }
+
+        if (step.targetArray)
+        {
+            step.targetArray->attachValue(step.targetIndex, std::move(value));
+            break;
+        }
+        if (step.targetIndex == std::string::npos)
+        {
+            step.targetIndex = step.targetParent->getValues().size();
+        }
+        step.targetParent->attachValue(step.targetIndex, step.targetKey, std::move(value));
+        break;
+    }
+    case EditKind::RENAME:
+        step.parent->renameKey(step.key, step.targetKey);
+        break;
+    }
+}
+
+void History::revertStep(EditStep &step)
+{
+    switch (step.kind)
+    {
+    case EditKind::INSERT:
+        step.held = step.array ? step.array->detachValue(step.index) : step.parent->detachValue(step.key);
+        break;
+    case EditKind::REMOVE:
+        if (step.array)
+        {
+            step.array->attachValue(step.index, std::move(step.held));
+            break;
+        }
+        step.parent->attachValue(step.index, step.key, std::move(step.held));
+        break;
+    case EditKind::REPLACE:
+        if (step.root)
+        {
+            step.root->swap(step.held);
+            break;
+        }
+        step.held = step.array ? step.array->replaceValue(step.index, std::move(step.held))
+                               : step.parent->replaceValue(step.key, std::move(step.held));
+        break;
+    case EditKind::MOVE:
+    {
+        std::unique_ptr<JSONValue> value = step.targetArray ? step.targetArray->detachValue(step.targetIndex)
+                                                            : step.targetParent->detachValue(step.targetKey);
+        if (step.array)
+        {
+            step.array->attachValue(step.index, std::move(value));
+            break;
+        }
+        step.parent->attachValue(step.index, step.key, std::move(value));
+        break;
+    }
+    case EditKind::RENAME:
+        step.parent->renameKey(step.targetKey, step.key);
+        break;
+    }
+}
@@ -0,0 +1,220 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "JSONArray.h"
+#include "JSONObject.h"
+
+/**
+ * Default number of edits that can be undone.
+ */
+const size_t DEFAULT_HISTORY_LIMIT = 100;
+
+/**
+ * Enum representing a primitive change to a JSON object or array.
+ */
+enum class EditKind
+{
+    INSERT,
+    REMOVE,
+    REPLACE,
+    MOVE,
+    RENAME
+};
+
+/**
+ * A primitive, reversible change of one key in a JSON object, of one
+ * position in a JSON array when array is set, or of the root of a document
+ * when root is set.
+ *
+ * Nodes are never copied: whichever node the step keeps out of the document
+ * in its current state is owned by the step, and applying or reverting the
+ * step relinks that same node.
+ */
+struct EditStep
+{
+    EditKind kind;
+    JSONObject *parent;
+    std::string key;
+    size_t index = std::string::npos;
+    std::unique_ptr<JSONValue> held;
+    JSONObject *targetParent = nullptr;
+    std::string targetKey;
+    size_t targetIndex = std::string::npos;
+    JSONArray *array = nullptr;
+    JSONArray *targetArray = nullptr;
+    std::unique_ptr<JSONValue> *root = nullptr;
+
+    EditStep(EditKind kind, JSONObject *parent, const std::string &key, std::unique_ptr<JSONValue> held = nullptr)
+        : kind(kind), parent(parent), key(key), held(std::move(held)) {}
+
+    /**
+     * Adds a key with a value, appending it to the object.
+     */
+    static EditStep insert(JSONObject *parent, const std::string &key, std::unique_ptr<JSONValue> value);
+
+    /**
+     * Removes a key together with its value.
+     */
+    static EditStep remove(JSONObject *parent, const std::string &key);
+
+    /**
+     * Replaces the value of an existing key.
+     */
+    static EditStep replace(JSONObject *parent, const std::string &key, std::unique_ptr<JSONValue> value);
+
+    /**
+     * Relinks the value of a key under another key, possibly of another object.
+     * The destination key is appended and must not exist.
+     */
+    static EditStep move(JSONObject *parent, const std::string &key, JSONObject *targetParent, const std::string &targetKey);
+
+    /**
+     * Renames a key in place.
+     */
+    static EditStep rename(JSONObject *parent, const std::string &key, const std::string &newKey);
+
+    /**
+     * Inserts a value into an array, before the value at a given position.
+     */
+    static EditStep insertAt(JSONArray *array, size_t index, std::unique_ptr<JSONValue> value);
+
+    /**
+     * Removes the value at a given position of an array.
+     */
+    static EditStep removeAt(JSONArray *array, size_t index);
+
+    /**
+     * Replaces the value at a given position of an array.
+     */
+    static EditStep replaceAt(JSONArray *array, size_t index, std::unique_ptr<JSONValue> value);
+
+    /**
+     * Replaces the root of a document.
+     */
+    static EditStep replaceRoot(std::unique_ptr<JSONValue> *root, std::unique_ptr<JSONValue> value);
+
+    /**
+     * Relinks a value from a key or array position to another, possibly of
+     * another container. Array positions are given by index, the target
+     * index as it is once the value has been taken out. An object target is
+     * inserted at targetIndex, or appended if it is npos, and must not exist.
+     */
+    static EditStep relink(JSONObject *parent, JSONArray *array, const std::string &key, size_t index,
+                           JSONObject *targetParent, JSONArray *targetArray, const std::string &targetKey, size_t targetIndex);
+};
+
+/**
+ * A user-visible edit, made of the steps it consists of.
+ *
+ * The objects and arrays a step changes drop their cached hashes
+ * themselves; the containers above them, from the root down, are listed
+ * in containers so that theirs are dropped whenever the edit is applied
+ * or reverted.
+ */
+struct Edit
+{
+    std::string description;
+    std::vector<EditStep> steps;
+    std::vector<JSONValue *> containers;
+};
+
+/**
+ * Applies edits to JSON objects and keeps them so they can be undone and redone.
+ *
+ * An edit costs memory proportional to its number of steps; the values it
+ * displaced are retained instead of being freed, so keeping many undo levels
+ * on a large document costs little more than the document itself. Retained
+ * values are freed when their edit is dropped from the history.
+ */
+class History
+{
+public:
+    /**
+     * Constructs an empty history.
+     *
+     * @param limit maximum number of edits that can be undone
+     */
+    History(size_t limit = DEFAULT_HISTORY_LIMIT);
+
+    ~History();
+
+    History(const History &) = delete;
+    History &operator=(const History &) = delete;
+
+    /**
+     * Applies an edit and records it. Discards the edits that could be redone.
+     *
+     * @param edit the edit to apply
+     */
+    void perform(Edit edit);
+
+    /**
+     * Reverts the most recent edit.
+     *
+     * @return the description of the undone edit, or an empty string if there is nothing to undo
+     */
+    std::string undo();
+
+    /**
+     * Reapplies the most recently undone edit.
+     *
+     * @return the description of the redone edit, or an empty string if there is nothing to redo
+     */
+    std::string redo();
+
+    /**
+     * Records an edit whose steps have already been applied one by one.
+     * Discards the edits that could be redone.
+     *
+     * @param edit the applied edit
+     */
+    void record(Edit edit);
+
+    /**
+     * Forgets all edits, freeing the values they retained.
+     */
+    void clear();
+
+    /**
+     * Applies a single step, for edits whose later steps depend on the
+     * document as the earlier ones leave it.
+     *
+     * @param step the step to apply
+     */
+    static void applyStep(EditStep &step);
+
+    /**
+     * Reverts a single step applied with applyStep.
+     *
+     * @param step the step to revert
+     */
+    static void revertStep(EditStep &step);
+
+    /**
+     * Reverts the steps of an edit in reverse order.
+     *
+     * @param edit the edit to revert
+     */
+    static void revert(Edit &edit);
+
+    /**
+     * Drops the cached hashes of the containers above the ones an edit changes.
+     *
+     * @param edit the edit that was applied or reverted
+     */
+    static void invalidate(const Edit &edit);
+
+private:
+    static void apply(Edit &edit);
+
+private:
+    std::deque<Edit> undoStack;
+    std::vector<Edit> redoStack;
+    size_t limit;
+};
+
+#endif
@@ -1,5 +1,13 @@
 #include "JSONArray.h"
 
+JSONArray::~JSONArray()
+{
+    std::vector<std::unique_ptr<JSONValue>> children;
+    releaseChildren(children);
+    destroyAll(children);
+    dropKeyFilter(cachedKeyFilter);
+}
+
 JSONValueType JSONArray::getType() const
 {
     return JSONValueType::ARRAY;
@@ -21,12 +29,75 @@ std::string JSONArray::toString() const
     return result;
 }
 
-void JSONArray::addValue(JSONValue *value)
+void JSONArray::releaseChildren(std::vector<std::unique_ptr<JSONValue>> &out)
+{
+    for (auto &value : values)
+    {
+        out.push_back(std::move(value));
+    }
+    values.clear();
+    invalidateHash();
+}
+
+void JSONArray::invalidateHash()
+{
+    cachedHash.store(0, std::memory_order_relaxed);
+    dropKeyFilter(cachedKeyFilter);
+}
+
+void JSONArray::addValue(std::unique_ptr<JSONValue> value)
+{
+    values.push_back(std::move(value));
+    invalidateHash();
+}
+
+void JSONArray::appendValue(std::unique_ptr<JSONValue> value)
 {
-    values.push_back(value);
+    values.push_back(std::move(value));
 }
 
-std::vector<JSONValue *> JSONArray::getValues() const
+const std::vector<std::unique_ptr<JSONValue>> &JSONArray::getValues() const
 {
     return values;
-}
\ No newline at end of file
+}
+
+void JSONArray::attachValue(size_t index, std::unique_ptr<JSONValue> value)
+{
+    values.insert(values.begin() + index, std::move(value));
+    invalidateHash();
+}
+
+std::unique_ptr<JSONValue> JSONArray::detachValue(size_t index)
+{
+    if (index >= values.size())
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<JSONValue> value = std::move(values[index]);
+    values.erase(values.begin() + index);
+    invalidateHash();
+    return value;
+}
+
+std::unique_ptr<JSONValue> JSONArray::replaceValue(size_t index, std::unique_ptr<JSONValue> newValue)
+{
+    if (index >= values.size())
+    {
+        return nullptr;
+    }
+
+    values[index].swap(newValue);
+    invalidateHash();
+    return newValue;
+}
+
+const SourceSpan &JSONArray::getSourceSpan() const
+{
+    return span;
+}
+
+void JSONArray::setSourceSpan(const SourceSpan &span)
+{
+    this->span = span;
+}
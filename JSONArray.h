@@ -3,28 +3,99 @@
 
 #include "JSONValue.h"
 
+#include <atomic>
+
+/**
+ * A JSON array. It owns its values: they are destroyed with it unless
+ * detached first, and values are handed in and out as std::unique_ptr.
+ */
 class JSONArray : public JSONValue
 {
 public:
+    JSONArray() = default;
+    ~JSONArray() override;
+
+    JSONArray(const JSONArray &) = delete;
+    JSONArray &operator=(const JSONArray &) = delete;
+
     JSONValueType getType() const override;
     std::string toString() const override;
+    void releaseChildren(std::vector<std::unique_ptr<JSONValue>> &out) override;
+    void invalidateHash() override;
 
     /**
      * Adds a JSON value to the values vector.
      * 
      * @param value the value to add
      */
-    void addValue(JSONValue *value);
+    void addValue(std::unique_ptr<JSONValue> value);
+
+    /**
+     * Adds a JSON value without dropping the cached hash and key filter. Only
+     * for arrays still being built by a parse, which have not cached either yet.
+     *
+     * @param value the value to add
+     */
+    void appendValue(std::unique_ptr<JSONValue> value);
 
     /**
      * Returns the values vector.
      * 
-     * @return Vector of JSONValue pointers containing the values
+     * @return Vector of the owned values
+     */
+    const std::vector<std::unique_ptr<JSONValue>> &getValues() const;
+
+    /**
+     * Inserts a value at a given position.
+     *
+     * @param index position to insert at, at most the number of values
+     * @param value the value to insert
+     */
+    void attachValue(size_t index, std::unique_ptr<JSONValue> value);
+
+    /**
+     * Removes the value at a given position and hands it to the caller.
+     *
+     * @param index position of the value
+     * @return the detached value, or nullptr if the index is out of range
      */
-    std::vector<JSONValue *> getValues() const;
+    std::unique_ptr<JSONValue> detachValue(size_t index);
+
+    /**
+     * Replaces the value at a given position and hands the old one to the caller.
+     *
+     * @param index position of the value
+     * @param newValue the value to put in its place
+     * @return the previous value, or nullptr if the index is out of range
+     */
+    std::unique_ptr<JSONValue> replaceValue(size_t index, std::unique_ptr<JSONValue> newValue);
+
+    /**
+     * Returns where the text of this value lies in the source it was parsed from.
+     */
+    const SourceSpan &getSourceSpan() const;
+
+    /**
+     * Records where the text of this value lies in the source it was parsed from.
+     *
+     * @param span the position of the text
+     */
+    void setSourceSpan(const SourceSpan &span);
 
 private:
-    std::vector<JSONValue *> values;
+    std::vector<std::unique_ptr<JSONValue>> values;
+
+    // Bloom filter of the keys below, null until built; shared like the
+    // hash. Kept next to the members, which a search reads with it.
+    mutable std::atomic<const KeyFilter *> cachedKeyFilter{nullptr};
+
+    SourceSpan span;
+
+    friend class JSONValue;
+
+    // hash of the contents, 0 until computed; atomic because readers
+    // sharing the document may compute it at the same time
+    mutable std::atomic<uint64_t> cachedHash{0};
 };
 
-#endif
\ No newline at end of file
+#endif
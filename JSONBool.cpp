@@ -11,3 +11,8 @@ std::string JSONBool::toString() const
 {
     return value ? "true" : "false";
 }
+
+bool JSONBool::getValue() const
+{
+    return value;
+}
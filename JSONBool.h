@@ -9,7 +9,12 @@ public:
     JSONBool(bool value);
     JSONValueType getType() const override;
     std::string toString() const override;
-    
+
+    /**
+     * Returns the boolean.
+     */
+    bool getValue() const;
+
 private:
     bool value;
 };
@@ -15,4 +15,9 @@ std::string JSONNumber::toString() const
     }
 
     return std::to_string(value);
-}
\ No newline at end of file
+}
+
+double JSONNumber::getValue() const
+{
+    return value;
+}
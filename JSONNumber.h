@@ -14,6 +14,11 @@ public:
 
     std::string toString() const override;
 
+    /**
+     * Returns the number.
+     */
+    double getValue() const;
+
 private:
     double value;
 };
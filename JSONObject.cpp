@@ -1,4 +1,69 @@
 #include "JSONObject.h"
+#include "StringCodec.h"
+
+#include <algorithm>
+
+namespace
+{
+    /**
+     * Decodes the UTF-8 sequence starting at a position.
+     */
+    uint32_t codePointAt(const std::string &text, size_t i)
+    {
+        unsigned char lead = static_cast<unsigned char>(text[i]);
+        if (lead < 0x80)
+        {
+            return lead;
+        }
+
+        size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+        uint32_t codePoint = lead & (0x7F >> length);
+        for (size_t j = 1; j < length && i + j < text.size(); j++)
+        {
+            codePoint = (codePoint << 6) | (static_cast<unsigned char>(text[i + j]) & 0x3F);
+        }
+        return codePoint;
+    }
+
+    /**
+     * Compares keys by their UTF-16 code units. UTF-8 bytes sort like code
+     * points, which differs only where a code point above U+FFFF, written
+     * as a surrogate pair in UTF-16, meets one from U+E000 to U+FFFF.
+     */
+    bool utf16Less(const std::string &a, const std::string &b)
+    {
+        size_t size = std::min(a.size(), b.size());
+        size_t i = 0;
+        while (i < size && a[i] == b[i])
+        {
+            i++;
+        }
+        if (i == size)
+        {
+            return a.size() < b.size();
+        }
+
+        // Go back to the start of the differing code point, which is shared by both keys.
+        while (i > 0 && (static_cast<unsigned char>(a[i]) & 0xC0) == 0x80)
+        {
+            i--;
+        }
+        uint32_t codeA = codePointAt(a, i);
+        uint32_t codeB = codePointAt(b, i);
+        uint32_t unitA = codeA < 0x10000 ? codeA : 0xD800 + ((codeA - 0x10000) >> 10);
+        uint32_t unitB = codeB < 0x10000 ? codeB : 0xD800 + ((codeB - 0x10000) >> 10);
+        return unitA != unitB ? unitA < unitB : codeA < codeB;
+    }
+}
+
+JSONObject::~JSONObject()
+{
+    std::vector<std::unique_ptr<JSONValue>> children;
+    releaseChildren(children);
+    destroyAll(children);
+    delete sortedOrder.load(std::memory_order_relaxed);
+    dropKeyFilter(cachedKeyFilter);
+}
 
 JSONValueType JSONObject::getType() const
 {
@@ -14,36 +79,67 @@ std::string JSONObject::toString() const
         {
             result += ", \n";
         }
-        result += "  \"" + values[i].key + "\": " + values[i].value->toString();
+        result += "  ";
+        StringCodec::appendQuoted(result, values[i].key);
+        result += ": " + values[i].value->toString();
     }
     result += "\n}";
     return result;
 }
 
-void JSONObject::addValue(const std::string &key, JSONValue *value)
+void JSONObject::releaseChildren(std::vector<std::unique_ptr<JSONValue>> &out)
 {
-    values.emplace_back(key, value);
+    for (auto &keyValue : values)
+    {
+        out.push_back(std::move(keyValue.value));
+    }
+    values.clear();
+    invalidateHash();
+    invalidateOrder();
+}
+
+void JSONObject::invalidateHash()
+{
+    cachedHash.store(0, std::memory_order_relaxed);
+    dropKeyFilter(cachedKeyFilter);
+}
+
+void JSONObject::invalidateOrder()
+{
+    delete sortedOrder.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+void JSONObject::addValue(const std::string &key, std::unique_ptr<JSONValue> value)
+{
+    values.emplace_back(key, std::move(value));
+    invalidateHash();
+    invalidateOrder();
 }
 
-std::vector<KeyValue> JSONObject::getValues() const
+void JSONObject::appendValue(const std::string &key, std::unique_ptr<JSONValue> value)
+{
+    values.emplace_back(key, std::move(value));
+}
+
+const std::vector<KeyValue> &JSONObject::getValues() const
 {
     return values;
 }
 
-void JSONObject::setValue(const std::string &key, JSONValue *newValue)
+void JSONObject::setValue(const std::string &key, std::unique_ptr<JSONValue> newValue)
 {
+    invalidateHash();
     for (auto &keyValue : values)
     {
         if (keyValue.key == key)
         {
-            delete keyValue.value;
-            keyValue.value = newValue;
-            std::cout << values[3].value->toString();
+            keyValue.value = std::move(newValue);
             return;
         }
     }
 
-    values.emplace_back(key, newValue);
+    values.emplace_back(key, std::move(newValue));
+    invalidateOrder();
 }
 
 JSONValue *JSONObject::getValue(const std::string &key)
@@ -52,7 +148,7 @@ JSONValue *JSONObject::getValue(const std::string &key)
     {
         if (keyValue.key == key)
         {
-            return keyValue.value;
+            return keyValue.value.get();
         }
     }
 
@@ -65,9 +161,116 @@ void JSONObject::removeValue(const std::string &key)
     {
         if (it->key == key)
         {
-            delete it->value;
             values.erase(it);
+            invalidateHash();
+            invalidateOrder();
             return;
         }
     }
-}
\ No newline at end of file
+}
+
+size_t JSONObject::indexOf(const std::string &key) const
+{
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (values[i].key == key)
+        {
+            return i;
+        }
+    }
+
+    return std::string::npos;
+}
+
+void JSONObject::attachValue(size_t index, const std::string &key, std::unique_ptr<JSONValue> value)
+{
+    values.emplace(values.begin() + index, key, std::move(value));
+    invalidateHash();
+    invalidateOrder();
+}
+
+std::unique_ptr<JSONValue> JSONObject::detachValue(const std::string &key)
+{
+    size_t index = indexOf(key);
+    if (index == std::string::npos)
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<JSONValue> value = std::move(values[index].value);
+    values.erase(values.begin() + index);
+    invalidateHash();
+    invalidateOrder();
+    return value;
+}
+
+std::unique_ptr<JSONValue> JSONObject::replaceValue(const std::string &key, std::unique_ptr<JSONValue> newValue)
+{
+    return replaceValueAt(indexOf(key), std::move(newValue));
+}
+
+std::unique_ptr<JSONValue> JSONObject::replaceValueAt(size_t index, std::unique_ptr<JSONValue> newValue)
+{
+    if (index >= values.size())
+    {
+        return nullptr;
+    }
+
+    values[index].value.swap(newValue);
+    invalidateHash();
+    return newValue;
+}
+
+bool JSONObject::renameKey(const std::string &key, const std::string &newKey)
+{
+    size_t index = indexOf(key);
+    if (index == std::string::npos)
+    {
+        return false;
+    }
+
+    values[index].key = newKey;
+    invalidateHash();
+    invalidateOrder();
+    return true;
+}
+
+const std::vector<uint32_t> &JSONObject::getSortedOrder() const
+{
+    const std::vector<uint32_t> *order = sortedOrder.load(std::memory_order_acquire);
+    if (order)
+    {
+        return *order;
+    }
+
+    std::vector<uint32_t> *sorted = new std::vector<uint32_t>(values.size());
+    for (uint32_t i = 0; i < sorted->size(); i++)
+    {
+        (*sorted)[i] = i;
+    }
+    std::stable_sort(sorted->begin(), sorted->end(), [this](uint32_t a, uint32_t b)
+                     { return utf16Less(values[a].key, values[b].key); });
+
+    const std::vector<uint32_t> *expected = nullptr;
+    if (!sortedOrder.compare_exchange_strong(expected, sorted, std::memory_order_acq_rel))
+    {
+        delete sorted;
+        return *expected;
+    }
+    return *sorted;
+}
+
+const std::vector<uint32_t> *JSONObject::getCachedSortedOrder() const
+{
+    return sortedOrder.load(std::memory_order_acquire);
+}
+
+const SourceSpan &JSONObject::getSourceSpan() const
+{
+    return span;
+}
+
+void JSONObject::setSourceSpan(const SourceSpan &span)
+{
+    this->span = span;
+}
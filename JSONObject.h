@@ -2,32 +2,45 @@
 #define JSON_OBJECT_H
 
 #include "JSONValue.h"
+#include <atomic>
 #include <iostream>
 
 /**
  * Structure representing a key-value pair where the key
- * is a std::string and the value is a JSONValue pointer.
+ * is a std::string and the value is a JSONValue owned by the pair.
  */
 struct KeyValue
 {
     std::string key;
-    JSONValue *value;
+    std::unique_ptr<JSONValue> value;
 
-    KeyValue(const std::string &key, JSONValue *value) : key(key), value(value) {}
+    KeyValue(const std::string &key, std::unique_ptr<JSONValue> value) : key(key), value(std::move(value)) {}
 };
 
+/**
+ * A JSON object. It owns its values: they are destroyed with it unless
+ * detached first, and values are handed in and out as std::unique_ptr.
+ */
 class JSONObject : public JSONValue
 {
 public:
+    JSONObject() = default;
+    ~JSONObject() override;
+
+    JSONObject(const JSONObject &) = delete;
+    JSONObject &operator=(const JSONObject &) = delete;
+
     JSONValueType getType() const override;
     std::string toString() const override;
+    void releaseChildren(std::vector<std::unique_ptr<JSONValue>> &out) override;
+    void invalidateHash() override;
 
     /**
      * Returns the values vector.
      *
      * @return Vector of KeyValue pairs containing the values
      */
-    std::vector<KeyValue> getValues() const;
+    const std::vector<KeyValue> &getValues() const;
 
     /**
      * Returns the value at a given key.
@@ -38,12 +51,13 @@ public:
     JSONValue *getValue(const std::string &key);
 
     /**
-     * Updates the value at a given key.
+     * Updates the value at a given key, destroying the old one.
+     * Adds the key if it is not present.
      *
      * @param key the key of the value to update
      * @param newValue the value to replace the old one with
      */
-    void setValue(const std::string &key, JSONValue *newValue);
+    void setValue(const std::string &key, std::unique_ptr<JSONValue> newValue);
 
     /**
      * Adds a new pair of key and value to the values vector.
@@ -51,17 +65,130 @@ public:
      * @param key
      * @param value
      */
-    void addValue(const std::string &key, JSONValue *value);
+    void addValue(const std::string &key, std::unique_ptr<JSONValue> value);
 
     /**
-     * Removes a value from the values vector.
+     * Adds a new pair of key and value without dropping the cached hash, key
+     * filter and key order. Only for objects still being built by a parse,
+     * which have not cached any of them yet.
+     *
+     * @param key
+     * @param value
+     */
+    void appendValue(const std::string &key, std::unique_ptr<JSONValue> value);
+
+    /**
+     * Removes a value from the values vector and destroys it.
      * 
      * @param key used to find the value to remove
      */
     void removeValue(const std::string &key);
 
+    /**
+     * Returns the position of a key in the values vector.
+     *
+     * @param key the key to look for
+     * @return index of the key, or std::string::npos if it is not present
+     */
+    size_t indexOf(const std::string &key) const;
+
+    /**
+     * Inserts a new pair of key and value at a given position.
+     *
+     * @param index position to insert at, at most the number of values
+     * @param key
+     * @param value
+     */
+    void attachValue(size_t index, const std::string &key, std::unique_ptr<JSONValue> value);
+
+    /**
+     * Removes a key from the values vector and hands its value to the caller.
+     *
+     * @param key the key of the value to detach
+     * @return the detached value, or nullptr if the key is not present
+     */
+    std::unique_ptr<JSONValue> detachValue(const std::string &key);
+
+    /**
+     * Replaces the value at a given key and hands the old one to the caller.
+     *
+     * @param key the key of the value to replace
+     * @param newValue the value to put in its place
+     * @return the previous value, or nullptr if the key is not present
+     */
+    std::unique_ptr<JSONValue> replaceValue(const std::string &key, std::unique_ptr<JSONValue> newValue);
+
+    /**
+     * Replaces the value at a given position and hands the old one to the caller.
+     *
+     * @param index position of the value to replace
+     * @param newValue the value to put in its place
+     * @return the previous value, or nullptr if the index is out of range
+     */
+    std::unique_ptr<JSONValue> replaceValueAt(size_t index, std::unique_ptr<JSONValue> newValue);
+
+    /**
+     * Renames a key in place, keeping its value and position.
+     *
+     * @param key the key to rename
+     * @param newKey the new name
+     * @return true if the key was present
+     */
+    bool renameKey(const std::string &key, const std::string &newKey);
+
+    /**
+     * Returns the positions of the values in the order of their keys by
+     * UTF-16 code units, which is the order canonical JSON (RFC 8785) sorts
+     * keys in. The order is sorted once and kept until a key is added,
+     * removed or renamed, so writing an object again does not sort it again.
+     *
+     * @return positions in the values vector, in sorted key order
+     */
+    const std::vector<uint32_t> &getSortedOrder() const;
+
+    /**
+     * Returns the sorted key order if it has been computed, without sorting.
+     *
+     * @return the cached order, or nullptr if there is none
+     */
+    const std::vector<uint32_t> *getCachedSortedOrder() const;
+
+    /**
+     * Returns where the text of this value lies in the source it was parsed from.
+     */
+    const SourceSpan &getSourceSpan() const;
+
+    /**
+     * Records where the text of this value lies in the source it was parsed from.
+     *
+     * @param span the position of the text
+     */
+    void setSourceSpan(const SourceSpan &span);
+
+private:
+    /**
+     * Drops the sorted order after the keys changed.
+     */
+    void invalidateOrder();
+
 private:
     std::vector<KeyValue> values;
+
+    // Bloom filter of the keys below, null until built; shared like the
+    // hash. Kept next to the members, which a search reads with it.
+    mutable std::atomic<const KeyFilter *> cachedKeyFilter{nullptr};
+
+    SourceSpan span;
+
+    friend class JSONValue;
+
+    // hash of the contents, 0 until computed; atomic because readers
+    // sharing the document may compute it at the same time
+    mutable std::atomic<uint64_t> cachedHash{0};
+
+    // sorted key order, null until computed; readers that sort at the same
+    // time each build one and the first to publish it wins
+    mutable std::atomic<const std::vector<uint32_t> *> sortedOrder{nullptr};
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,69 @@
+#include "JSONPointer.h"
+
+#include <stdexcept>
+
+std::vector<std::string> JSONPointer::parse(const std::string &pointer)
+{
+    std::vector<std::string> tokens;
+    if (pointer.empty())
+    {
+        return tokens;
+    }
+    if (pointer[0] != '/')
+    {
+        throw std::runtime_error("JSON Pointer must start with '/': " + pointer);
+    }
+
+    for (size_t pos = 0; pos < pointer.size(); pos++)
+    {
+        char c = pointer[pos];
+        if (c == '/')
+        {
+            tokens.emplace_back();
+        }
+        else if (c != '~')
+        {
+            tokens.back() += c;
+        }
+        else if (pos + 1 < pointer.size() && (pointer[pos + 1] == '0' || pointer[pos + 1] == '1'))
+        {
+            tokens.back() += pointer[++pos] == '0' ? '~' : '/';
+        }
+        else
+        {
+            throw std::runtime_error("Invalid escape in JSON Pointer: " + pointer);
+        }
+    }
+    return tokens;
+}
+
+void JSONPointer::append(std::string &pointer, const std::string &token)
+{
+    pointer += '/';
+    for (char c : token)
+    {
+        if (c == '~')
+        {
+            pointer += "~0";
+        }
+        else if (c == '/')
+        {
+            pointer += "~1";
+        }
+        else
+        {
+            pointer += c;
+        }
+    }
+}
+
+bool JSONPointer::toIndex(const std::string &token, size_t &index)
+{
+    if (token.empty() || token.size() > 19 || (token[0] == '0' && token.size() > 1) ||
+        token.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return false;
+    }
+    index = std::stoull(token);
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef JSON_POINTER_H
+#define JSON_POINTER_H
+
+#include <string>
+#include <vector>
+
+/**
+ * JSON Pointers as defined by RFC 6901, the paths used by JSON Patch.
+ * A pointer is a sequence of reference tokens, each preceded by '/',
+ * in which '~' is written as "~0" and '/' as "~1".
+ */
+class JSONPointer
+{
+public:
+    /**
+     * Splits a pointer into its reference tokens and unescapes them.
+     *
+     * @param pointer the pointer; the empty pointer refers to the whole document
+     *
+     * @return the reference tokens
+     * @throws {std::runtime_error} if the pointer does not start with '/' or holds an invalid escape
+     */
+    static std::vector<std::string> parse(const std::string &pointer);
+
+    /**
+     * Appends a reference token to a pointer, escaping it.
+     *
+     * @param pointer the pointer to extend
+     * @param token the unescaped reference token
+     */
+    static void append(std::string &pointer, const std::string &token);
+
+    /**
+     * Reads a reference token as an array index: digits without leading zeros.
+     *
+     * @param token the reference token
+     * @param index receives the index
+     *
+     * @return false if the token is not an array index
+     */
+    static bool toIndex(const std::string &token, size_t &index);
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "JSONString.h"
+#include "StringCodec.h"
 
 JSONString::JSONString(const std::string &value) : value(value) {}
 
@@ -9,5 +10,13 @@ JSONValueType JSONString::getType() const
 
 std::string JSONString::toString() const
 {
-    return "\"" + value + "\"";
+    std::string result;
+    result.reserve(value.size() + 2);
+    StringCodec::appendQuoted(result, value);
+    return result;
+}
+
+const std::string &JSONString::getValue() const
+{
+    return value;
 }
\ No newline at end of file
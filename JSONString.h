@@ -11,6 +11,12 @@ public:
     JSONValueType getType() const override;
 
     std::string toString() const override;
+
+    /**
+     * Returns the string without surrounding quotes.
+     */
+    const std::string &getValue() const;
+
 private:
     std::string value;
 };
@@ -0,0 +1,532 @@
+#include "JSONValue.h"
+#include "JSONArray.h"
+#include "JSONBool.h"
+#include "JSONNull.h"
+#include "JSONNumber.h"
+#include "JSONObject.h"
+#include "JSONString.h"
+#include "KeyFilter.h"
+
+#include <cstring>
+
+void JSONValue::releaseChildren(std::vector<std::unique_ptr<JSONValue>> &) {}
+
+void JSONValue::invalidateHash() {}
+
+void JSONValue::dropKeyFilter(std::atomic<const KeyFilter *> &cache)
+{
+    // Checked first because mutators call this on every change, mostly
+    // with nothing cached.
+    if (!cache.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    const KeyFilter *filter = cache.exchange(nullptr, std::memory_order_acq_rel);
+    if (filter != KeyFilter::unfiltered())
+    {
+        delete filter;
+    }
+}
+
+void JSONValue::destroyAll(std::vector<std::unique_ptr<JSONValue>> &values)
+{
+    while (!values.empty())
+    {
+        std::unique_ptr<JSONValue> value = std::move(values.back());
+        values.pop_back();
+        value->releaseChildren(values);
+    }
+}
+
+namespace
+{
+    /**
+     * An object or array whose members are being copied, and its copy.
+     */
+    struct CopyFrame
+    {
+        const JSONValue *source;
+        JSONValue *copy;
+        size_t index;
+    };
+
+    /**
+     * Copies a scalar, or creates an empty object or array.
+     */
+    std::unique_ptr<JSONValue> copyShallow(const JSONValue *value)
+    {
+        switch (value->getType())
+        {
+        case JSONValueType::STRING:
+            return std::unique_ptr<JSONValue>(new JSONString(static_cast<const JSONString *>(value)->getValue()));
+        case JSONValueType::NUMBER:
+            return std::unique_ptr<JSONValue>(new JSONNumber(static_cast<const JSONNumber *>(value)->getValue()));
+        case JSONValueType::BOOL:
+            return std::unique_ptr<JSONValue>(new JSONBool(static_cast<const JSONBool *>(value)->getValue()));
+        case JSONValueType::OBJECT:
+            return std::unique_ptr<JSONValue>(new JSONObject());
+        case JSONValueType::ARRAY:
+            return std::unique_ptr<JSONValue>(new JSONArray());
+        default:
+            return std::unique_ptr<JSONValue>(new JSONNull());
+        }
+    }
+}
+
+std::unique_ptr<JSONValue> JSONValue::copy(const JSONValue *value)
+{
+    std::unique_ptr<JSONValue> result = copyShallow(value);
+    std::vector<CopyFrame> stack;
+    if (value->getType() == JSONValueType::OBJECT || value->getType() == JSONValueType::ARRAY)
+    {
+        stack.push_back({value, result.get(), 0});
+    }
+
+    while (!stack.empty())
+    {
+        CopyFrame &frame = stack.back();
+        const JSONValue *member;
+        JSONValue *memberCopy;
+
+        if (frame.source->getType() == JSONValueType::OBJECT)
+        {
+            const auto &values = static_cast<const JSONObject *>(frame.source)->getValues();
+            if (frame.index == values.size())
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            const KeyValue &keyValue = values[frame.index++];
+            member = keyValue.value.get();
+            std::unique_ptr<JSONValue> copied = copyShallow(member);
+            memberCopy = copied.get();
+            static_cast<JSONObject *>(frame.copy)->addValue(keyValue.key, std::move(copied));
+        }
+        else
+        {
+            const auto &values = static_cast<const JSONArray *>(frame.source)->getValues();
+            if (frame.index == values.size())
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            member = values[frame.index++].get();
+            std::unique_ptr<JSONValue> copied = copyShallow(member);
+            memberCopy = copied.get();
+            static_cast<JSONArray *>(frame.copy)->addValue(std::move(copied));
+        }
+
+        if (member->getType() == JSONValueType::OBJECT || member->getType() == JSONValueType::ARRAY)
+        {
+            stack.push_back({member, memberCopy, 0});
+        }
+    }
+
+    return result;
+}
+
+namespace
+{
+    const uint64_t STRING_SEED = 0x9e3779b97f4a7c15ULL;
+    const uint64_t NUMBER_SEED = 0xc2b2ae3d27d4eb4fULL;
+    const uint64_t BOOL_SEED = 0x165667b19e3779f9ULL;
+    const uint64_t NULL_SEED = 0xd6e8feb86659fd93ULL;
+    const uint64_t ARRAY_SEED = 0x27d4eb2f165667c5ULL;
+    const uint64_t OBJECT_SEED = 0x85ebca77c2b2ae63ULL;
+    const uint64_t KEY_SEED = 0xff51afd7ed558ccdULL;
+
+    /**
+     * Scrambles the bits of a 64-bit value (the splitmix64 finalizer).
+     */
+    uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    /**
+     * Hashes a string eight bytes at a time.
+     */
+    uint64_t hashText(const std::string &text, uint64_t seed)
+    {
+        uint64_t h = seed ^ text.size();
+        size_t pos = 0;
+        for (; pos + 8 <= text.size(); pos += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, text.data() + pos, 8);
+            h = (h ^ mix(word)) * 0x9e3779b97f4a7c15ULL;
+        }
+
+        uint64_t tail = 0;
+        std::memcpy(&tail, text.data() + pos, text.size() - pos);
+        return mix(h ^ tail);
+    }
+
+    uint64_t hashScalar(const JSONValue *value)
+    {
+        switch (value->getType())
+        {
+        case JSONValueType::STRING:
+            return hashText(static_cast<const JSONString *>(value)->getValue(), STRING_SEED);
+        case JSONValueType::NUMBER:
+        {
+            // 0 and -0 are the same number.
+            double number = static_cast<const JSONNumber *>(value)->getValue();
+            if (number == 0)
+            {
+                number = 0;
+            }
+            uint64_t bits;
+            std::memcpy(&bits, &number, sizeof(bits));
+            return mix(bits ^ NUMBER_SEED);
+        }
+        case JSONValueType::BOOL:
+            return mix(BOOL_SEED + static_cast<const JSONBool *>(value)->getValue());
+        default:
+            return mix(NULL_SEED);
+        }
+    }
+
+    /**
+     * An object or array whose members are being hashed, with the hash of
+     * the members folded in so far.
+     */
+    struct HashFrame
+    {
+        const JSONValue *container;
+        size_t index;
+        uint64_t state;
+    };
+
+    /**
+     * Folds the hash of the member just passed into the hash of its container.
+     * Array members are folded in order, object members as a sum, so that
+     * the order of an object's keys does not matter.
+     */
+    void fold(HashFrame &frame, uint64_t memberHash)
+    {
+        if (frame.container->getType() == JSONValueType::OBJECT)
+        {
+            const KeyValue &keyValue = static_cast<const JSONObject *>(frame.container)->getValues()[frame.index - 1];
+            frame.state += mix(hashText(keyValue.key, KEY_SEED) ^ (memberHash * 0x9e3779b97f4a7c15ULL));
+        }
+        else
+        {
+            frame.state = mix(frame.state ^ memberHash) + ARRAY_SEED;
+        }
+    }
+
+    size_t memberCount(const JSONValue *container)
+    {
+        if (container->getType() == JSONValueType::OBJECT)
+        {
+            return static_cast<const JSONObject *>(container)->getValues().size();
+        }
+        return static_cast<const JSONArray *>(container)->getValues().size();
+    }
+}
+
+std::atomic<uint64_t> *JSONValue::hashCacheOf(const JSONValue *value)
+{
+    switch (value->getType())
+    {
+    case JSONValueType::OBJECT:
+        return &static_cast<const JSONObject *>(value)->cachedHash;
+    case JSONValueType::ARRAY:
+        return &static_cast<const JSONArray *>(value)->cachedHash;
+    default:
+        return nullptr;
+    }
+}
+
+uint64_t JSONValue::hash() const
+{
+    std::atomic<uint64_t> *cache = hashCacheOf(this);
+    if (!cache)
+    {
+        return hashScalar(this);
+    }
+    uint64_t cached = cache->load(std::memory_order_relaxed);
+    if (cached != 0)
+    {
+        return cached;
+    }
+
+    std::vector<HashFrame> stack = {{this, 0, getType() == JSONValueType::OBJECT ? 0 : ARRAY_SEED}};
+    uint64_t result = 0;
+    while (!stack.empty())
+    {
+        HashFrame &frame = stack.back();
+        size_t size = memberCount(frame.container);
+        if (frame.index == size)
+        {
+            uint64_t seed = frame.container->getType() == JSONValueType::OBJECT ? OBJECT_SEED : ARRAY_SEED;
+            uint64_t containerHash = mix(frame.state ^ seed ^ size);
+            // 0 marks a hash that is not computed yet.
+            if (containerHash == 0)
+            {
+                containerHash = 1;
+            }
+            hashCacheOf(frame.container)->store(containerHash, std::memory_order_relaxed);
+            stack.pop_back();
+
+            if (stack.empty())
+            {
+                result = containerHash;
+            }
+            else
+            {
+                fold(stack.back(), containerHash);
+            }
+            continue;
+        }
+
+        const JSONValue *member;
+        if (frame.container->getType() == JSONValueType::OBJECT)
+        {
+            member = static_cast<const JSONObject *>(frame.container)->getValues()[frame.index].value.get();
+        }
+        else
+        {
+            member = static_cast<const JSONArray *>(frame.container)->getValues()[frame.index].get();
+        }
+        frame.index++;
+
+        std::atomic<uint64_t> *memberCache = hashCacheOf(member);
+        if (!memberCache)
+        {
+            fold(frame, hashScalar(member));
+            continue;
+        }
+
+        uint64_t memberHash = memberCache->load(std::memory_order_relaxed);
+        if (memberHash != 0)
+        {
+            fold(frame, memberHash);
+            continue;
+        }
+        stack.push_back({member, 0, member->getType() == JSONValueType::OBJECT ? 0 : ARRAY_SEED});
+    }
+
+    return result;
+}
+
+namespace
+{
+    /**
+     * An object or array whose keys are being gathered into a filter.
+     */
+    struct FilterFrame
+    {
+        const JSONValue *container;
+        size_t index;
+        KeyFilter keys;
+        size_t nodes;
+    };
+}
+
+std::atomic<const KeyFilter *> *JSONValue::keyFilterCacheOf(const JSONValue *value)
+{
+    switch (value->getType())
+    {
+    case JSONValueType::OBJECT:
+        return &static_cast<const JSONObject *>(value)->cachedKeyFilter;
+    case JSONValueType::ARRAY:
+        return &static_cast<const JSONArray *>(value)->cachedKeyFilter;
+    default:
+        return nullptr;
+    }
+}
+
+const KeyFilter *JSONValue::publishKeyFilter(std::atomic<const KeyFilter *> *cache, const KeyFilter &keys, size_t nodes)
+{
+    const KeyFilter *filter = nodes < KeyFilter::MIN_NODES ? KeyFilter::unfiltered() : new KeyFilter(keys);
+    const KeyFilter *expected = nullptr;
+    if (!cache->compare_exchange_strong(expected, filter, std::memory_order_acq_rel))
+    {
+        // Another reader built the same filter first.
+        if (filter != KeyFilter::unfiltered())
+        {
+            delete filter;
+        }
+        return expected;
+    }
+    return filter;
+}
+
+void JSONValue::setKeyFilter(const KeyFilter &keys, size_t nodes)
+{
+    std::atomic<const KeyFilter *> *cache = keyFilterCacheOf(this);
+    if (cache)
+    {
+        dropKeyFilter(*cache);
+        cache->store(nodes < KeyFilter::MIN_NODES ? KeyFilter::unfiltered() : new KeyFilter(keys), std::memory_order_release);
+    }
+}
+
+bool JSONValue::ownsKeyFilter() const
+{
+    std::atomic<const KeyFilter *> *cache = keyFilterCacheOf(this);
+    if (!cache)
+    {
+        return false;
+    }
+    const KeyFilter *cached = cache->load(std::memory_order_acquire);
+    return cached && cached != KeyFilter::unfiltered();
+}
+
+const KeyFilter *JSONValue::keyFilter() const
+{
+    std::atomic<const KeyFilter *> *cache = keyFilterCacheOf(this);
+    if (!cache)
+    {
+        return nullptr;
+    }
+    const KeyFilter *cached = cache->load(std::memory_order_acquire);
+    if (cached)
+    {
+        return cached;
+    }
+    return buildKeyFilter();
+}
+
+const KeyFilter *JSONValue::buildKeyFilter() const
+{
+    std::vector<FilterFrame> stack = {{this, 0, KeyFilter(), 0}};
+    while (true)
+    {
+        FilterFrame &frame = stack.back();
+        if (frame.index == memberCount(frame.container))
+        {
+            const KeyFilter *filter = publishKeyFilter(keyFilterCacheOf(frame.container), frame.keys, frame.nodes);
+            if (stack.size() == 1)
+            {
+                return filter;
+            }
+            FilterFrame &parent = stack[stack.size() - 2];
+            parent.keys.merge(frame.keys);
+            parent.nodes += frame.nodes;
+            stack.pop_back();
+            continue;
+        }
+
+        const JSONValue *member;
+        if (frame.container->getType() == JSONValueType::OBJECT)
+        {
+            const KeyValue &keyValue = static_cast<const JSONObject *>(frame.container)->getValues()[frame.index];
+            frame.keys.add(KeyFilter::hashKey(keyValue.key));
+            member = keyValue.value.get();
+        }
+        else
+        {
+            member = static_cast<const JSONArray *>(frame.container)->getValues()[frame.index].get();
+        }
+        frame.index++;
+        frame.nodes++;
+
+        std::atomic<const KeyFilter *> *memberCache = keyFilterCacheOf(member);
+        if (!memberCache)
+        {
+            continue;
+        }
+
+        // A member with a filter of its own has at least MIN_NODES values
+        // below it, which is all the count is needed for. A small member
+        // has no keys on record and is walked.
+        const KeyFilter *memberFilter = memberCache->load(std::memory_order_acquire);
+        if (memberFilter && memberFilter != KeyFilter::unfiltered())
+        {
+            frame.keys.merge(*memberFilter);
+            frame.nodes += KeyFilter::MIN_NODES;
+            continue;
+        }
+        stack.push_back({member, 0, KeyFilter(), 0});
+    }
+}
+
+bool JSONValue::equal(const JSONValue *a, const JSONValue *b)
+{
+    std::vector<std::pair<const JSONValue *, const JSONValue *>> pending = {{a, b}};
+    while (!pending.empty())
+    {
+        const JSONValue *x = pending.back().first;
+        const JSONValue *y = pending.back().second;
+        pending.pop_back();
+        if (x == y)
+        {
+            continue;
+        }
+        if (x->getType() != y->getType())
+        {
+            return false;
+        }
+
+        switch (x->getType())
+        {
+        case JSONValueType::STRING:
+            if (static_cast<const JSONString *>(x)->getValue() != static_cast<const JSONString *>(y)->getValue())
+            {
+                return false;
+            }
+            break;
+        case JSONValueType::NUMBER:
+            if (static_cast<const JSONNumber *>(x)->getValue() != static_cast<const JSONNumber *>(y)->getValue())
+            {
+                return false;
+            }
+            break;
+        case JSONValueType::BOOL:
+            if (static_cast<const JSONBool *>(x)->getValue() != static_cast<const JSONBool *>(y)->getValue())
+            {
+                return false;
+            }
+            break;
+        case JSONValueType::OBJECT:
+        {
+            const JSONObject *other = static_cast<const JSONObject *>(y);
+            const auto &members = static_cast<const JSONObject *>(x)->getValues();
+            const auto &otherMembers = other->getValues();
+            if (members.size() != otherMembers.size() || x->hash() != y->hash())
+            {
+                return false;
+            }
+            for (size_t i = 0; i < members.size(); i++)
+            {
+                // Keys are usually in the same order; look them up otherwise.
+                size_t index = otherMembers[i].key == members[i].key ? i : other->indexOf(members[i].key);
+                if (index == std::string::npos)
+                {
+                    return false;
+                }
+                pending.push_back({members[i].value.get(), otherMembers[index].value.get()});
+            }
+            break;
+        }
+        case JSONValueType::ARRAY:
+        {
+            const auto &elements = static_cast<const JSONArray *>(x)->getValues();
+            const auto &otherElements = static_cast<const JSONArray *>(y)->getValues();
+            if (elements.size() != otherElements.size() || x->hash() != y->hash())
+            {
+                return false;
+            }
+            for (size_t i = 0; i < elements.size(); i++)
+            {
+                pending.push_back({elements[i].get(), otherElements[i].get()});
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    return true;
+}
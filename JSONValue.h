@@ -1,9 +1,14 @@
 #ifndef JSON_VALUE_H
 #define JSON_VALUE_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
+struct KeyFilter;
+
 enum class JSONValueType
 {
     STRING,
@@ -14,6 +19,18 @@ enum class JSONValueType
     NILL
 };
 
+/**
+ * Where the text of an object or array lies in the source it was parsed from.
+ * The offset is counted from the opening bracket of the enclosing container,
+ * or from the start of the source for the root, so that an edit only moves
+ * the spans of the containers around it. The length includes both brackets.
+ */
+struct SourceSpan
+{
+    size_t offset = 0;
+    size_t length = 0;
+};
+
 class JSONValue
 {
 public:
@@ -28,6 +45,122 @@ public:
      * Converts the JSON value into a string.
      */
     virtual std::string toString() const = 0; 
+
+    /**
+     * Moves the values owned by this value into a vector, leaving it empty.
+     * Used to tear down deep trees without recursion.
+     *
+     * @param out vector receiving the owned values
+     */
+    virtual void releaseChildren(std::vector<std::unique_ptr<JSONValue>> &out);
+
+    /**
+     * Makes a deep copy of a value. Nested objects and arrays are copied
+     * with an explicit stack, so any depth can be copied.
+     *
+     * @param value the value to copy
+     * @return the copy, owned by the caller
+     */
+    static std::unique_ptr<JSONValue> copy(const JSONValue *value);
+
+    /**
+     * Returns a 64-bit hash of the contents of the value. Equal values have
+     * equal hashes, objects whatever the order of their keys. The hash of an
+     * object or array is built from the hashes of its members and cached,
+     * so it is computed once until the value changes; nested containers are
+     * hashed with an explicit stack, so any depth can be hashed.
+     */
+    uint64_t hash() const;
+
+    /**
+     * Drops the cached hash and key filter of an object or array. Its own
+     * mutators do this; whoever changes a value must also call it on every
+     * container on the path from the root down to the changed one.
+     */
+    virtual void invalidateHash();
+
+    /**
+     * Returns a Bloom filter of every key in the subtree of an object or
+     * array, or nullptr for other values. Subtrees with fewer than
+     * KeyFilter::MIN_NODES values get KeyFilter::unfiltered(), which may
+     * contain any key. The filter is built from the cached filters of the
+     * members and cached itself, so after a change only the containers on
+     * the path to it are summarized again.
+     */
+    const KeyFilter *keyFilter() const;
+
+    /**
+     * Caches the key filter of an object or array built by whoever created
+     * it, such as the parser, while no other thread can see the value.
+     * Does nothing for other values.
+     *
+     * @param keys the keys in the subtree
+     * @param nodes the number of values in the subtree, not counting this one
+     */
+    void setKeyFilter(const KeyFilter &keys, size_t nodes);
+
+    /**
+     * Returns true if an object or array has built a key filter of its own,
+     * rather than none yet or the shared KeyFilter::unfiltered().
+     */
+    bool ownsKeyFilter() const;
+
+    /**
+     * Returns true if two values have the same contents. Objects are equal
+     * regardless of the order of their keys. Values whose hashes differ are
+     * told apart at once; others are compared member by member, skipping
+     * subtrees that are the same node.
+     *
+     * @param a one value
+     * @param b the other value
+     */
+    static bool equal(const JSONValue *a, const JSONValue *b);
+
+protected:
+    /**
+     * Destroys a list of values and everything they own, using an explicit
+     * stack so that the depth of the tree does not matter.
+     *
+     * @param values the values to destroy
+     */
+    static void destroyAll(std::vector<std::unique_ptr<JSONValue>> &values);
+
+    /**
+     * Frees a cached key filter and marks it as not built.
+     *
+     * @param cache where the filter is cached
+     */
+    static void dropKeyFilter(std::atomic<const KeyFilter *> &cache);
+
+private:
+    /**
+     * Returns where an object or array caches its hash, nullptr for other values.
+     */
+    static std::atomic<uint64_t> *hashCacheOf(const JSONValue *value);
+
+    /**
+     * Returns where an object or array caches its key filter, nullptr for other values.
+     */
+    static std::atomic<const KeyFilter *> *keyFilterCacheOf(const JSONValue *value);
+
+    /**
+     * Builds and caches the key filter of this object or array and of the
+     * members below it that have none.
+     *
+     * @return the cached filter
+     */
+    const KeyFilter *buildKeyFilter() const;
+
+    /**
+     * Caches a key filter unless one is cached already.
+     *
+     * @param cache where the filter goes
+     * @param keys the keys in the subtree
+     * @param nodes the number of values in the subtree
+     *
+     * @return the cached filter
+     */
+    static const KeyFilter *publishKeyFilter(std::atomic<const KeyFilter *> *cache, const KeyFilter &keys, size_t nodes);
 };
 
-#endif
\ No newline at end of file
+#endif
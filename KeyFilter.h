@@ -0,0 +1,100 @@
+#ifndef KEY_FILTER_H
+#define KEY_FILTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+ * A 256-bit Bloom filter of the keys found in a subtree. Each key sets two
+ * bits chosen by one 64-bit hash, so a key that is absent is reported as
+ * possibly present only when both of its bits were set by other keys.
+ * Filters of subtrees are combined by merging their bits.
+ */
+struct KeyFilter
+{
+    // Containers with fewer values than this below them get no filter of
+    // their own; they are cheaper to walk than to summarize.
+    static const size_t MIN_NODES = 256;
+
+    uint64_t bits[4] = {0, 0, 0, 0};
+
+    /**
+     * Hashes a key for add and mayContain, so that a key looked up in many
+     * filters is hashed once. Only the length and the first and last eight
+     * bytes are mixed in, so every key costs the same to hash; keys that
+     * differ only further inside share bits, which costs pruning, never
+     * results.
+     *
+     * @param key the key
+     */
+    static uint64_t hashKey(std::string_view key)
+    {
+        const char *data = key.data();
+        size_t size = key.size();
+        uint64_t first = 0;
+        uint64_t last = 0;
+        if (size >= 8)
+        {
+            std::memcpy(&first, data, 8);
+            std::memcpy(&last, data + size - 8, 8);
+        }
+        else if (size >= 4)
+        {
+            uint32_t head;
+            uint32_t tail;
+            std::memcpy(&head, data, 4);
+            std::memcpy(&tail, data + size - 4, 4);
+            first = head;
+            last = tail;
+        }
+        else if (size > 0)
+        {
+            first = static_cast<unsigned char>(data[0]) | static_cast<unsigned char>(data[size / 2]) << 8 |
+                    static_cast<unsigned char>(data[size - 1]) << 16;
+        }
+
+        uint64_t hash = (first ^ size * 0x9E3779B97F4A7C15ULL) * 0xBF58476D1CE4E5B9ULL;
+        hash = (hash ^ (hash >> 31) ^ last) * 0x94D049BB133111EBULL;
+        return hash ^ (hash >> 29);
+    }
+
+    void add(uint64_t keyHash)
+    {
+        bits[(keyHash >> 6) & 3] |= 1ULL << (keyHash & 63);
+        bits[(keyHash >> 14) & 3] |= 1ULL << ((keyHash >> 8) & 63);
+    }
+
+    /**
+     * Returns false if no key with the given hash was added, true if one may have been.
+     *
+     * @param keyHash the hash of the key, from hashKey
+     */
+    bool mayContain(uint64_t keyHash) const
+    {
+        return (bits[(keyHash >> 6) & 3] >> (keyHash & 63) & 1) &&
+               (bits[(keyHash >> 14) & 3] >> ((keyHash >> 8) & 63) & 1);
+    }
+
+    void merge(const KeyFilter &other)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            bits[i] |= other.bits[i];
+        }
+    }
+
+    /**
+     * Returns the filter shared by every container too small to have its
+     * own. It may contain any key, so searches walk such containers, and
+     * it is never freed.
+     */
+    static const KeyFilter *unfiltered()
+    {
+        static const KeyFilter all{{~0ULL, ~0ULL, ~0ULL, ~0ULL}};
+        return &all;
+    }
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include "Lexer.h"
 
-Lexer::Lexer(const std::string &input) : input(input), pos(0), line(1), column(1) {}
+#include <algorithm>
+
+Lexer::Lexer(std::string input) : input(std::move(input)), pos(0), line(1), column(1) {}
 
 size_t Lexer::getLine()
 {
@@ -12,8 +14,29 @@ size_t Lexer::getColumn()
     return column;
 }
 
+size_t Lexer::getInputSize() const
+{
+    return input.size();
+}
+
+const std::string &Lexer::getInput() const
+{
+    return input;
+}
+
+size_t Lexer::getPos() const
+{
+    return pos;
+}
+
+size_t Lexer::getRetainedBytes() const
+{
+    return input.capacity();
+}
+
 Token Lexer::nextToken()
 {
+    JSON_STATS_ADD(stats, tokensProduced, 1);
     skipWhitespace();
 
     if (pos >= input.length())
@@ -49,7 +72,7 @@ Token Lexer::nextToken()
     case 'n':
         return parseKeyword();
     default:
-        if (isdigit(curr) || curr == '-')
+        if (CharClass::isDigit(curr) || curr == '-')
         {
             return parseNumber();
         }
@@ -59,9 +82,18 @@ Token Lexer::nextToken()
 
 void Lexer::resetPos()
 {
+    JSON_STATS_ADD(stats, bytesScanned, pos - statsPos);
+    statsPos = 0;
     pos = 0;
 }
 
+void Lexer::publishStats()
+{
+    JSON_STATS_ADD(stats, bytesScanned, pos - statsPos);
+    statsPos = pos;
+    JSON_STATS_PUBLISH(stats);
+}
+
 void Lexer::advance()
 {
     if (input[pos] == '\n')
@@ -78,7 +110,7 @@ void Lexer::advance()
 
 void Lexer::skipWhitespace()
 {
-    while (pos < input.size() && isspace(input[pos]))
+    while (pos < input.size() && CharClass::isWhitespace(input[pos]))
     {
         advance();
     }
@@ -87,34 +119,83 @@ void Lexer::skipWhitespace()
 Token Lexer::parseString()
 {
     size_t start = pos + 1;
-    advance();
-    while (pos < input.size() && input[pos] != '"')
+    size_t end = start;
+    bool escaped = false;
+
+    while (true)
     {
-        advance();
+        end += StringCodec::findSpecial(input.data() + end, input.size() - end);
+        if (end >= input.size())
+        {
+            throw std::runtime_error("Unterminated string at line " + std::to_string(line) + ", column " + std::to_string(column));
+        }
+
+        char c = input[end];
+        if (c == '"')
+        {
+            break;
+        }
+        if (c != '\\')
+        {
+            column += end - pos;
+            throw std::runtime_error("Unescaped control character in string at line " + std::to_string(line) + ", column " + std::to_string(column));
+        }
+
+        // The escaped character is checked when the string is decoded.
+        escaped = true;
+        end = std::min(end + 2, input.size());
+    }
+
+    size_t invalid = StringCodec::validateUtf8(input.data() + start, end - start);
+    if (invalid != end - start)
+    {
+        column += start + invalid - pos;
+        throw std::runtime_error("Invalid UTF-8 in string at line " + std::to_string(line) + ", column " + std::to_string(column));
+    }
+
+    Token token(TokenType::STRING);
+    if (escaped)
+    {
+        try
+        {
+            StringCodec::unescape(input.data() + start, end - start, token.value);
+        }
+        catch (const std::runtime_error &e)
+        {
+            throw std::runtime_error(std::string(e.what()) + " at line " + std::to_string(line) + ", column " + std::to_string(column));
+        }
     }
-    if (pos >= input.size())
+    else
     {
-        throw std::runtime_error("Unterminated string at line " + std::to_string(line) + ", column " + std::to_string(column));
+        token.value.assign(input, start, end - start);
     }
-    size_t end = pos;
-    advance();
-    return {TokenType::STRING, input.substr(start, end - start)};
+
+    // Strings cannot contain line breaks, so only the column moves.
+    column += end + 1 - pos;
+    pos = end + 1;
+    return token;
 }
 
 Token Lexer::parseNumber()
 {
     size_t start = pos;
-    while (pos < input.size() && (isdigit(input[pos]) || input[pos] == '.' || input[pos] == '-' || input[pos] == '+'))
+    size_t startColumn = column;
+    while (pos < input.size() && CharClass::isNumber(input[pos]))
     {
         advance();
     }
-    return {TokenType::NUMBER, input.substr(start, pos - start)};
+    std::string number = input.substr(start, pos - start);
+    if (!CharClass::isValidNumber(number))
+    {
+        throw std::runtime_error("Invalid number '" + number + "' at line " + std::to_string(line) + ", column " + std::to_string(startColumn));
+    }
+    return {TokenType::NUMBER, std::move(number)};
 }
 
 Token Lexer::parseKeyword()
 {
     size_t start = pos;
-    while (pos < input.size() && isalpha(input[pos]))
+    while (pos < input.size() && CharClass::isAlpha(input[pos]))
     {
         advance();
     }
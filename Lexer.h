@@ -6,6 +6,10 @@
 #include <iostream>
 #include <string>
 
+#include "CharClass.h"
+#include "Stats.h"
+#include "StringCodec.h"
+
 /**
  * Enum representing the type of a token in JSON.
  */
@@ -25,6 +29,11 @@ enum class TokenType
     END
 };
 
+/**
+ * Default limit on how deeply objects and arrays may be nested.
+ */
+const size_t DEFAULT_MAX_DEPTH = 1000000;
+
 /**
  * Structure representing a token in JSON.
  */
@@ -47,7 +56,7 @@ public:
      * Constructs a Lexer object with the given input.
      * @param input JSON input string.
      */
-    Lexer(const std::string &input);
+    Lexer(std::string input);
 
     /**
      * Gets the current line number.
@@ -61,6 +70,30 @@ public:
      */
     size_t getColumn();
 
+    /**
+     * Gets the length of the input.
+     * @return Input length in bytes.
+     */
+    size_t getInputSize() const;
+
+    /**
+     * Gets the input text.
+     * @return The input the lexer reads from.
+     */
+    const std::string &getInput() const;
+
+    /**
+     * Gets the current position in the input.
+     * @return Offset of the next character to read.
+     */
+    size_t getPos() const;
+
+    /**
+     * Gets the number of bytes held by the lexer's copy of the input.
+     * @return Allocated size of the retained input.
+     */
+    size_t getRetainedBytes() const;
+
     /**
      * Gets the next token from the input.
      * @return The next token.
@@ -72,6 +105,11 @@ public:
      */
     void resetPos();
 
+    /**
+     * Publishes the bytes scanned and tokens produced since the last call to the global statistics.
+     */
+    void publishStats();
+
 private:
     /**
      * Advances the current position by one character.
@@ -84,7 +122,8 @@ private:
     void skipWhitespace();
 
     /**
-     * Parses a string token.
+     * Parses a string token, decoding escape sequences.
+     * Rejects unescaped control characters and invalid UTF-8.
      * @return The parsed string token.
      */
     Token parseString();
@@ -106,6 +145,9 @@ private:
     size_t pos;
     size_t line;
     size_t column;
+
+    StatCounters stats;
+    size_t statsPos = 0;
 };
 
 #endif
@@ -0,0 +1,177 @@
+#include "MemoryReport.h"
+
+#include <iomanip>
+
+#include "JSONArray.h"
+#include "JSONBool.h"
+#include "JSONNull.h"
+#include "JSONNumber.h"
+#include "JSONObject.h"
+#include "JSONString.h"
+#include "KeyFilter.h"
+
+namespace
+{
+    // Bookkeeping glibc malloc adds to every block, rounded to its alignment.
+    const size_t MALLOC_BLOCK_OVERHEAD = 16;
+
+    void printLine(std::ostream &out, const std::string &name, size_t bytes, size_t total)
+    {
+        double percent = total ? 100.0 * bytes / total : 0;
+        out << std::left << std::setw(22) << name << std::right << std::setw(14) << bytes
+            << std::setw(8) << std::fixed << std::setprecision(1) << percent << "%" << std::endl;
+    }
+}
+
+size_t MemoryUsage::total() const
+{
+    return objectOverhead + arrayOverhead + keyStorage + stringPayload + numbers + literals +
+           vectorSlack + caches + retainedInput + allocatorOverhead;
+}
+
+double MemoryUsage::bytesPerInputByte() const
+{
+    return inputBytes ? static_cast<double>(total()) / inputBytes : 0;
+}
+
+MemoryUsage MemoryReport::measure(const JSONValue *root, size_t inputBytes, size_t retainedInput)
+{
+    MemoryUsage usage;
+    usage.inputBytes = inputBytes;
+    usage.retainedInput = retainedInput;
+    if (retainedInput > 0)
+    {
+        countBlock(usage);
+    }
+
+    std::vector<const JSONValue *> stack;
+    if (root)
+    {
+        stack.push_back(root);
+    }
+
+    while (!stack.empty())
+    {
+        const JSONValue *value = stack.back();
+        stack.pop_back();
+        countBlock(usage);
+        if (value->ownsKeyFilter())
+        {
+            usage.caches += sizeof(KeyFilter);
+            countBlock(usage);
+        }
+
+        switch (value->getType())
+        {
+        case JSONValueType::OBJECT:
+        {
+            const JSONObject *object = static_cast<const JSONObject *>(value);
+            const auto &values = object->getValues();
+            usage.objectCount++;
+            usage.objectOverhead += sizeof(JSONObject);
+            usage.keyStorage += values.size() * sizeof(KeyValue);
+            usage.vectorSlack += (values.capacity() - values.size()) * sizeof(KeyValue);
+            if (values.capacity() > 0)
+            {
+                countBlock(usage);
+            }
+
+            const std::vector<uint32_t> *order = object->getCachedSortedOrder();
+            if (order)
+            {
+                usage.caches += sizeof(*order) + order->capacity() * sizeof(uint32_t);
+                countBlock(usage);
+                if (order->capacity() > 0)
+                {
+                    countBlock(usage);
+                }
+            }
+
+            for (const auto &keyValue : values)
+            {
+                usage.keyStorage += heapBytes(keyValue.key, usage);
+                stack.push_back(keyValue.value.get());
+            }
+            break;
+        }
+        case JSONValueType::ARRAY:
+        {
+            const auto &values = static_cast<const JSONArray *>(value)->getValues();
+            usage.arrayCount++;
+            usage.arrayOverhead += sizeof(JSONArray) + values.size() * sizeof(values[0]);
+            usage.vectorSlack += (values.capacity() - values.size()) * sizeof(values[0]);
+            if (values.capacity() > 0)
+            {
+                countBlock(usage);
+            }
+
+            for (const auto &item : values)
+            {
+                stack.push_back(item.get());
+            }
+            break;
+        }
+        case JSONValueType::STRING:
+            usage.stringCount++;
+            usage.stringPayload += sizeof(JSONString) + heapBytes(static_cast<const JSONString *>(value)->getValue(), usage);
+            break;
+        case JSONValueType::NUMBER:
+            usage.numberCount++;
+            usage.numbers += sizeof(JSONNumber);
+            break;
+        case JSONValueType::BOOL:
+            usage.literalCount++;
+            usage.literals += sizeof(JSONBool);
+            break;
+        case JSONValueType::NILL:
+            usage.literalCount++;
+            usage.literals += sizeof(JSONNull);
+            break;
+        }
+    }
+
+    return usage;
+}
+
+void MemoryReport::print(const MemoryUsage &usage, std::ostream &out)
+{
+    size_t total = usage.total();
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+
+    out << "Nodes: " << usage.objectCount << " objects, " << usage.arrayCount << " arrays, "
+        << usage.stringCount << " strings, " << usage.numberCount << " numbers, "
+        << usage.literalCount << " literals" << std::endl;
+    printLine(out, "object overhead", usage.objectOverhead, total);
+    printLine(out, "array overhead", usage.arrayOverhead, total);
+    printLine(out, "key storage", usage.keyStorage, total);
+    printLine(out, "string payloads", usage.stringPayload, total);
+    printLine(out, "numbers", usage.numbers, total);
+    printLine(out, "true/false/null", usage.literals, total);
+    printLine(out, "vector slack", usage.vectorSlack, total);
+    printLine(out, "key filters, orders", usage.caches, total);
+    printLine(out, "retained input", usage.retainedInput, total);
+    printLine(out, "allocator overhead", usage.allocatorOverhead, total);
+    printLine(out, "total", total, total);
+    out << "Input size: " << usage.inputBytes << " bytes, " << std::setprecision(2)
+        << usage.bytesPerInputByte() << " bytes per input byte" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+size_t MemoryReport::heapBytes(const std::string &string, MemoryUsage &usage)
+{
+    static const size_t inlineCapacity = std::string().capacity();
+    if (string.capacity() <= inlineCapacity)
+    {
+        return 0;
+    }
+
+    countBlock(usage);
+    return string.capacity() + 1;
+}
+
+void MemoryReport::countBlock(MemoryUsage &usage)
+{
+    usage.allocatorOverhead += MALLOC_BLOCK_OVERHEAD;
+}
@@ -0,0 +1,87 @@
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <iostream>
+
+#include "JSONValue.h"
+
+/**
+ * Structure holding the memory used by a loaded document, broken down by category.
+ * All sizes are in bytes.
+ */
+struct MemoryUsage
+{
+    size_t inputBytes = 0;
+
+    size_t objectCount = 0;
+    size_t arrayCount = 0;
+    size_t stringCount = 0;
+    size_t numberCount = 0;
+    size_t literalCount = 0;
+
+    size_t objectOverhead = 0;
+    size_t arrayOverhead = 0;
+    size_t keyStorage = 0;
+    size_t stringPayload = 0;
+    size_t numbers = 0;
+    size_t literals = 0;
+    size_t vectorSlack = 0;
+    // key filters and sorted key orders built by searches and canonical writes
+    size_t caches = 0;
+    size_t retainedInput = 0;
+    size_t allocatorOverhead = 0;
+
+    /**
+     * Returns the sum of all categories.
+     */
+    size_t total() const;
+
+    /**
+     * Returns the number of bytes used per byte of input.
+     */
+    double bytesPerInputByte() const;
+};
+
+/**
+ * Measures the memory used by a JSONValue tree.
+ */
+class MemoryReport
+{
+public:
+    /**
+     * Walks a JSON tree and accounts for every node it owns.
+     *
+     * @param root the root of the tree
+     * @param inputBytes size of the text the tree was parsed from
+     * @param retainedInput bytes still held for the input text
+     *
+     * @return the memory usage broken down by category
+     */
+    static MemoryUsage measure(const JSONValue *root, size_t inputBytes, size_t retainedInput);
+
+    /**
+     * Prints a memory usage report.
+     *
+     * @param usage the usage to print
+     * @param out the stream to print to
+     */
+    static void print(const MemoryUsage &usage, std::ostream &out);
+
+private:
+    /**
+     * Returns the heap bytes used by a string, 0 if it fits in the inline buffer.
+     *
+     * @param string the string to measure
+     * @param usage usage whose allocator overhead is updated
+     */
+    static size_t heapBytes(const std::string &string, MemoryUsage &usage);
+
+    /**
+     * Accounts for the malloc header of a heap block.
+     *
+     * @param usage usage whose allocator overhead is updated
+     */
+    static void countBlock(MemoryUsage &usage);
+};
+
+#endif
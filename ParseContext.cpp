@@ -0,0 +1,30 @@
+#include "ParseContext.h"
+
+namespace
+{
+    /**
+     * The text a context's parser points at until it is given one.
+     */
+    const std::string NO_INPUT;
+}
+
+ParseContext::ParseContext(size_t maxDepth) : sink(stats), parser(NO_INPUT, maxDepth) {}
+
+std::unique_ptr<JSONValue> ParseContext::parse(const std::string &text, size_t baseDepth)
+{
+    parser.reset(text, baseDepth);
+    try
+    {
+        parser.parse(sink);
+    }
+    catch (const std::runtime_error &)
+    {
+        // Free the part of the tree built before the error now, not at the next parse.
+        sink.reset();
+        JSON_STATS_PUBLISH(stats);
+        throw;
+    }
+
+    JSON_STATS_PUBLISH(stats);
+    return sink.takeRoot();
+}
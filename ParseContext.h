@@ -0,0 +1,51 @@
+#ifndef PARSE_CONTEXT_H
+#define PARSE_CONTEXT_H
+
+#include <memory>
+#include <string>
+
+#include "BasicParser.h"
+#include "DomSink.h"
+
+/**
+ * Everything needed to parse JSON texts into trees, for one thread.
+ *
+ * A context shares no mutable state with any other context, so threads
+ * that each use their own can parse at the same time without locks; only
+ * the statistics, which are published once per text, are process-wide. A
+ * context keeps the storage its parser and sink have grown, such as the
+ * stack of open containers and the buffer for decoding escapes, so parsing
+ * many texts with one context does not allocate it again for each.
+ *
+ * A context must not be used by two threads at once. For a single text,
+ * Parser::parseDocument parses with a context of its own.
+ */
+class ParseContext
+{
+public:
+    /**
+     * @param maxDepth maximum nesting depth of objects and arrays
+     */
+    explicit ParseContext(size_t maxDepth = DEFAULT_MAX_DEPTH);
+
+    ParseContext(const ParseContext &) = delete;
+    ParseContext &operator=(const ParseContext &) = delete;
+
+    /**
+     * Parses a JSON text into a tree. The text must hold exactly one value.
+     *
+     * @param text the JSON text
+     * @param baseDepth nesting depth of the position the value is parsed at
+     *
+     * @return the parsed JSONValue
+     * @throws {std::runtime_error} if the text is not valid JSON or nests deeper than the maximum depth
+     */
+    std::unique_ptr<JSONValue> parse(const std::string &text, size_t baseDepth = 0);
+
+private:
+    StatCounters stats;
+    DomSink sink;
+    BasicParser<DomSink> parser;
+};
+
+#endif
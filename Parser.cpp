@@ -1,21 +1,383 @@
 #include "Parser.h"
+#include "JSONPointer.h"
 
-Parser::Parser(const std::string &stringInput) : lexer(stringInput)
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    /**
+     * Returns the source span of an object or array, nullptr for other values.
+     */
+    const SourceSpan *spanOf(const JSONValue *value)
+    {
+        switch (value->getType())
+        {
+        case JSONValueType::OBJECT:
+            return &static_cast<const JSONObject *>(value)->getSourceSpan();
+        case JSONValueType::ARRAY:
+            return &static_cast<const JSONArray *>(value)->getSourceSpan();
+        default:
+            return nullptr;
+        }
+    }
+
+    void setSpanOf(JSONValue *value, const SourceSpan &span)
+    {
+        if (value->getType() == JSONValueType::OBJECT)
+        {
+            static_cast<JSONObject *>(value)->setSourceSpan(span);
+        }
+        else if (value->getType() == JSONValueType::ARRAY)
+        {
+            static_cast<JSONArray *>(value)->setSourceSpan(span);
+        }
+    }
+
+    /**
+     * Returns the number of members of an object or array.
+     */
+    size_t childCount(const JSONValue *container)
+    {
+        if (container->getType() == JSONValueType::OBJECT)
+        {
+            return static_cast<const JSONObject *>(container)->getValues().size();
+        }
+        return static_cast<const JSONArray *>(container)->getValues().size();
+    }
+
+    /**
+     * Returns a member of an object or array by position.
+     */
+    JSONValue *childAt(const JSONValue *container, size_t index)
+    {
+        if (container->getType() == JSONValueType::OBJECT)
+        {
+            return static_cast<const JSONObject *>(container)->getValues()[index].value.get();
+        }
+        return static_cast<const JSONArray *>(container)->getValues()[index].get();
+    }
+
+    /**
+     * Where a JSON Patch operation applies: a key of an object or a position in an array.
+     */
+    struct PatchLocation
+    {
+        JSONObject *object = nullptr;
+        JSONArray *array = nullptr;
+        std::string key;
+        size_t index = 0;
+        // the value now at the location, nullptr if there is none
+        JSONValue *value = nullptr;
+        bool whole = false;
+    };
+
+    /**
+     * Returns the member of an object or array a JSON Pointer token names, nullptr if there is none.
+     */
+    JSONValue *memberOf(JSONValue *container, const std::string &token)
+    {
+        size_t index;
+        if (container->getType() == JSONValueType::OBJECT)
+        {
+            return static_cast<JSONObject *>(container)->getValue(token);
+        }
+        if (container->getType() == JSONValueType::ARRAY && JSONPointer::toIndex(token, index) &&
+            index < static_cast<JSONArray *>(container)->getValues().size())
+        {
+            return static_cast<JSONArray *>(container)->getValues()[index].get();
+        }
+        return nullptr;
+    }
+
+    /**
+     * Adds the objects and arrays along a path, as far as it exists, to the
+     * containers whose cached hashes an edit drops.
+     *
+     * @param edit the edit
+     * @param root the document
+     * @param tokens the keys or indexes leading to the changed value
+     */
+    void addPath(Edit &edit, JSONValue *root, const std::vector<std::string> &tokens)
+    {
+        JSONValue *current = root;
+        for (size_t i = 0; current; i++)
+        {
+            if (current->getType() != JSONValueType::OBJECT && current->getType() != JSONValueType::ARRAY)
+            {
+                break;
+            }
+            edit.containers.push_back(current);
+            if (i == tokens.size())
+            {
+                break;
+            }
+            current = memberOf(current, tokens[i]);
+        }
+    }
+
+    /**
+     * Finds the location a JSON Pointer refers to.
+     *
+     * @param root the document
+     * @param pointer the JSON Pointer
+     * @param adding true if a value is to be added there, which allows a
+     *        new key, and "-" or the size of the array as an index
+     *
+     * @throws {std::runtime_error} if the location does not exist
+     */
+    PatchLocation locate(JSONValue *root, const std::string &pointer, bool adding)
+    {
+        PatchLocation location;
+        std::vector<std::string> tokens = JSONPointer::parse(pointer);
+        if (tokens.empty())
+        {
+            location.value = root;
+            location.whole = true;
+            return location;
+        }
+
+        JSONValue *parent = root;
+        for (size_t i = 0; i + 1 < tokens.size() && parent; i++)
+        {
+            parent = memberOf(parent, tokens[i]);
+        }
+
+        const std::string &last = tokens.back();
+        if (parent && parent->getType() == JSONValueType::OBJECT)
+        {
+            location.object = static_cast<JSONObject *>(parent);
+            location.key = last;
+            location.value = location.object->getValue(last);
+        }
+        else if (parent && parent->getType() == JSONValueType::ARRAY)
+        {
+            location.array = static_cast<JSONArray *>(parent);
+            size_t size = location.array->getValues().size();
+            if (adding && last == "-")
+            {
+                location.index = size;
+            }
+            else if (!JSONPointer::toIndex(last, location.index) || location.index > size || (!adding && location.index == size))
+            {
+                throw std::runtime_error("invalid array index in " + pointer);
+            }
+            if (location.index < size)
+            {
+                location.value = location.array->getValues()[location.index].get();
+            }
+        }
+
+        if (!location.value && !(adding && (location.object || location.array)))
+        {
+            throw std::runtime_error("path not found: " + pointer);
+        }
+        return location;
+    }
+
+    /**
+     * Returns a string member of a JSON Patch operation.
+     *
+     * @throws {std::runtime_error} if the member is missing or not a string
+     */
+    const std::string &operationMember(JSONObject *operation, const std::string &name)
+    {
+        JSONValue *value = operation->getValue(name);
+        if (!value || value->getType() != JSONValueType::STRING)
+        {
+            throw std::runtime_error("missing \"" + name + "\" member");
+        }
+        return static_cast<JSONString *>(value)->getValue();
+    }
+
+    /**
+     * Returns the step adding a value at a location, replacing the value of
+     * an existing key or the whole document.
+     */
+    EditStep addStep(const PatchLocation &location, std::unique_ptr<JSONValue> value, std::unique_ptr<JSONValue> &root)
+    {
+        if (location.whole)
+        {
+            return EditStep::replaceRoot(&root, std::move(value));
+        }
+        if (location.array)
+        {
+            return EditStep::insertAt(location.array, location.index, std::move(value));
+        }
+        if (location.value)
+        {
+            return EditStep::replace(location.object, location.key, std::move(value));
+        }
+        return EditStep::insert(location.object, location.key, std::move(value));
+    }
+
+    EditStep removeStep(const PatchLocation &location)
+    {
+        if (location.whole)
+        {
+            throw std::runtime_error("the whole document cannot be removed");
+        }
+        if (location.array)
+        {
+            return EditStep::removeAt(location.array, location.index);
+        }
+        return EditStep::remove(location.object, location.key);
+    }
+
+    EditStep replaceStep(const PatchLocation &location, std::unique_ptr<JSONValue> value, std::unique_ptr<JSONValue> &root)
+    {
+        if (location.whole)
+        {
+            return EditStep::replaceRoot(&root, std::move(value));
+        }
+        if (location.array)
+        {
+            return EditStep::replaceAt(location.array, location.index, std::move(value));
+        }
+        return EditStep::replace(location.object, location.key, std::move(value));
+    }
+
+    /**
+     * Flushes a written file to disk and gives it the permissions of the
+     * file it is about to replace, if there is one.
+     *
+     * @return false if the file could not be flushed
+     */
+    bool syncFile(const std::string &file, const std::string &replaced)
+    {
+        int fd = ::open(file.c_str(), O_WRONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+        if (::stat(replaced.c_str(), &info) == 0)
+        {
+            ::fchmod(fd, info.st_mode & 07777);
+        }
+
+        bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+        return synced;
+    }
+
+    /**
+     * Flushes the directory entry of a renamed file to disk.
+     */
+    void syncDirectory(const std::string &file)
+    {
+        size_t slash = file.rfind('/');
+        std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : file.substr(0, slash));
+        int fd = ::open(directory.c_str(), O_RDONLY);
+        if (fd >= 0)
+        {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    /**
+     * Returns the number of leading bytes two strings have in common.
+     */
+    size_t commonPrefix(const std::string &a, const std::string &b)
+    {
+        const size_t CHUNK = 4096;
+        size_t limit = std::min(a.size(), b.size());
+        size_t length = 0;
+
+        while (length + CHUNK <= limit && std::memcmp(a.data() + length, b.data() + length, CHUNK) == 0)
+        {
+            length += CHUNK;
+        }
+        while (length < limit && a[length] == b[length])
+        {
+            length++;
+        }
+        return length;
+    }
+
+    /**
+     * Returns the number of trailing bytes two strings have in common,
+     * not counting more than limit bytes.
+     */
+    size_t commonSuffix(const std::string &a, const std::string &b, size_t limit)
+    {
+        const size_t CHUNK = 4096;
+        const char *aEnd = a.data() + a.size();
+        const char *bEnd = b.data() + b.size();
+        size_t length = 0;
+
+        while (length + CHUNK <= limit && std::memcmp(aEnd - length - CHUNK, bEnd - length - CHUNK, CHUNK) == 0)
+        {
+            length += CHUNK;
+        }
+        while (length < limit && *(aEnd - length - 1) == *(bEnd - length - 1))
+        {
+            length++;
+        }
+        return length;
+    }
+}
+
+Parser::Parser(const std::string &stringInput, size_t maxDepth) : lexer(stringInput), maxDepth(maxDepth), context(maxDepth)
 {
-    root = parseValue();
+    JSON_STATS_PHASE(Phase::PARSE);
+    root = parseText(lexer.getInput());
+    JSON_STATS_PUBLISH(stats);
 }
 
-Parser::~Parser()
+Parser::Parser(ChunkReader &reader, size_t maxDepth) : lexer(""), maxDepth(maxDepth), context(maxDepth)
 {
-    delete root;
+    JSON_STATS_PHASE(Phase::PARSE);
+
+    // Each chunk is parsed while the reader prepares the next one.
+    std::string input;
+    std::string chunk;
+    DomSink sink(stats);
+    PushParser<DomSink> parser(sink, maxDepth);
+    while (reader.next(chunk))
+    {
+        parser.feed(chunk);
+        input += chunk;
+    }
+    parser.finish();
+
+    root = sink.takeRoot();
+    lexer = Lexer(std::move(input));
+    JSON_STATS_PUBLISH(stats);
 }
 
+Parser::~Parser() {}
+
 bool Parser::validate()
 {
-    Validator validator(lexer);
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (!sourceInSync)
+    {
+        Validator validator(Lexer(currentText()), maxDepth);
+        return validator.validate();
+    }
+    Validator validator(lexer, maxDepth);
     return validator.validate();
 }
 
+bool Parser::validateSchema(const Schema &schema, std::string &error)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    if (!sourceInSync)
+    {
+        Validator validator(Lexer(currentText()), maxDepth);
+        return validator.validate(schema, error);
+    }
+    Validator validator(lexer, maxDepth);
+    return validator.validate(schema, error);
+}
+
 JSONValue *Parser::parse()
 {
     if (!validate())
@@ -23,31 +385,56 @@ JSONValue *Parser::parse()
         std::cerr << "Invalid JSON input!" << std::endl;
     }
 
-    return parseValue();
+    return parseText(lexer.getInput()).release();
 }
 
 void Parser::writeToFile(const std::string &filePath)
 {
-    std::ofstream outFile(filePath);
-    if (!outFile.is_open())
+    std::string error;
+    if (!writeFile(filePath, "", error))
     {
-        throw std::runtime_error("Could not open file to write.");
+        throw std::runtime_error(error);
     }
-    print();
-    writeJSON(outFile, root, 0);
-    outFile.close();
 }
 
-void Parser::print()
+void Parser::print(std::ostream &out)
 {
-    Printer::print(root);
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::SERIALIZE);
+    Printer::write(out, root.get());
+}
+
+bool Parser::print(const std::string &path, const PrintLimits &limits, std::ostream &out)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::SERIALIZE);
+
+    JSONValue *target = nullptr;
+    try
+    {
+        target = root ? navigateToPath(root.get(), splitPath(path)) : nullptr;
+    }
+    catch (const std::exception &)
+    {
+        // An array index that is not a number names no value.
+    }
+
+    if (!target)
+    {
+        return false;
+    }
+    Printer::write(out, target, limits);
+    return true;
 }
 
 std::vector<JSONValue *> Parser::searchKey(const std::string &key)
 {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::SEARCH);
+
     try
     {
-        return Searcher::searchByKey(static_cast<JSONObject *>(root), key);
+        return Searcher::searchByKey(static_cast<JSONObject *>(root.get()), key);
     }
     catch (const std::runtime_error &e)
     {
@@ -56,27 +443,73 @@ std::vector<JSONValue *> Parser::searchKey(const std::string &key)
     }
 }
 
+size_t Parser::searchKey(const std::string &key, std::ostream &out, size_t limit, bool *stoppedEarly)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::SEARCH);
+
+    out << "[";
+    size_t written = 0;
+    bool more = false;
+    if (root)
+    {
+        // The search goes on past the last value written until it finds one
+        // more, so that stopping early is told apart from running out.
+        Searcher::searchByKey(root.get(), key, [&](JSONValue *value)
+                              {
+                                  if (written == limit)
+                                  {
+                                      more = true;
+                                      return false;
+                                  }
+                                  out << (written > 0 ? ",\n  " : "\n  ");
+                                  Printer::write(out, value, 2);
+                                  // The first match is shown at once; later ones follow as the stream fills.
+                                  if (written++ == 0)
+                                  {
+                                      out.flush();
+                                  }
+                                  return true;
+                              });
+    }
+    out << (written > 0 ? "\n]" : "]");
+    if (stoppedEarly)
+    {
+        *stoppedEarly = more;
+    }
+    return written;
+}
+
 bool Parser::contains(const std::string &value)
 {
-    return root && containsHelper(root, value);
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::SEARCH);
+    return root && Searcher::containsValue(root.get(), value);
 }
 
-bool Parser::set(const std::string &path, const std::string &newValue)
+bool Parser::set(const std::string &path, const std::string &newValue, bool *changed, std::ostream &err)
 {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::MUTATE);
+    if (changed)
+    {
+        *changed = false;
+    }
+
     if (!root)
     {
-        std::cerr << "No JSON structure parsed." << std::endl;
+        err << "No JSON structure parsed." << std::endl;
         return false;
     }
 
     std::vector<std::string> tokens = splitPath(path);
     if (tokens.empty())
     {
-        std::cerr << "Invalid JSON path." << std::endl;
+        err << "Invalid JSON path." << std::endl;
         return false;
     }
 
-    JSONValue *parent = root;
+    JSONValue *parent = root.get();
     std::string lastToken = tokens.back();
     tokens.pop_back();
 
@@ -85,7 +518,7 @@ bool Parser::set(const std::string &path, const std::string &newValue)
         JSONObject *obj = dynamic_cast<JSONObject *>(parent);
         if (!obj)
         {
-            std::cerr << "Invalid path: " << path << std::endl;
+            err << "Invalid path: " << path << std::endl;
             return false;
         }
         parent = obj->getValue(token);
@@ -94,46 +527,58 @@ bool Parser::set(const std::string &path, const std::string &newValue)
     JSONObject *parentObj = dynamic_cast<JSONObject *>(parent);
     if (!parentObj)
     {
-        std::cerr << "Invalid path: " << path << std::endl;
+        err << "Invalid path: " << path << std::endl;
         return false;
     }
 
     JSONValue *target = parentObj->getValue(lastToken);
     if (!target)
     {
-        std::cerr << "Path not found: " << path << std::endl;
+        err << "Path not found: " << path << std::endl;
         return false;
     }
 
-    Lexer valueLexer(newValue);
-    JSONValue *parsedNewValue = parseNewValue(valueLexer);
-    if (!parsedNewValue)
+    std::unique_ptr<JSONValue> parsedNewValue = parseNewValue(newValue);
+
+    // Setting a value to what it already is changes nothing, so nothing is recorded.
+    if (JSONValue::equal(target, parsedNewValue.get()))
     {
-        std::cerr << "Invalid new value: " << newValue << std::endl;
-        return false;
+        return true;
     }
 
-    parentObj->setValue(lastToken, parsedNewValue);
+    Edit edit{"set " + path, {}, {}};
+    edit.steps.push_back(EditStep::replace(parentObj, lastToken, std::move(parsedNewValue)));
+    addPath(edit, root.get(), tokens);
+    history.perform(std::move(edit));
+    sourceInSync = false;
+    if (changed)
+    {
+        *changed = true;
+    }
 
     return true;
 }
 
-bool Parser::create(const std::string &path, const std::string &newValue)
+bool Parser::create(const std::string &path, const std::string &newValue, std::ostream &err)
 {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::MUTATE);
+
     if (!root)
     {
-        std::cerr << "No JSON structure parsed." << std::endl;
+        err << "No JSON structure parsed." << std::endl;
         return false;
     }
 
     std::vector<std::string> tokens = splitPath(path);
     if (tokens.empty())
     {
-        std::cerr << "Invalid JSON path." << std::endl;
+        err << "Invalid JSON path." << std::endl;
         return false;
     }
 
-    JSONValue *parent = root;
+    Edit edit{"create " + path, {}, {}};
+    JSONValue *parent = root.get();
     std::string lastToken = tokens.back();
     tokens.pop_back();
 
@@ -142,14 +587,15 @@ bool Parser::create(const std::string &path, const std::string &newValue)
         JSONObject *obj = dynamic_cast<JSONObject *>(parent);
         if (!obj)
         {
-            std::cerr << "Invalid path: " << path << std::endl;
+            err << "Invalid path: " << path << std::endl;
             return false;
         }
-        JSONValue *nextValue = obj->getValue(token);
+        JSONValue *nextValue = edit.steps.empty() ? obj->getValue(token) : nullptr;
         if (!nextValue)
         {
-            nextValue = new JSONObject();
-            obj->setValue(token, nextValue);
+            std::unique_ptr<JSONObject> newObj(new JSONObject());
+            nextValue = newObj.get();
+            edit.steps.push_back(EditStep::insert(obj, token, std::move(newObj)));
         }
         parent = nextValue;
     }
@@ -157,45 +603,45 @@ bool Parser::create(const std::string &path, const std::string &newValue)
     JSONObject *parentObj = dynamic_cast<JSONObject *>(parent);
     if (!parentObj)
     {
-        std::cerr << "Invalid path: " << path << std::endl;
+        err << "Invalid path: " << path << std::endl;
         return false;
     }
 
     if (parentObj->getValue(lastToken))
     {
-        std::cerr << "Element already exists at path: " << path << std::endl;
+        err << "Element already exists at path: " << path << std::endl;
         return false;
     }
 
-    Lexer valueLexer(newValue);
-    JSONValue *parsedNewValue = parseNewValue(valueLexer);
-    if (!parsedNewValue)
-    {
-        std::cerr << "Invalid new value: " << newValue << std::endl;
-        return false;
-    }
+    std::unique_ptr<JSONValue> parsedNewValue = parseNewValue(newValue);
 
-    parentObj->setValue(lastToken, parsedNewValue);
+    edit.steps.push_back(EditStep::insert(parentObj, lastToken, std::move(parsedNewValue)));
+    addPath(edit, root.get(), tokens);
+    history.perform(std::move(edit));
+    sourceInSync = false;
 
     return true;
 }
 
-bool Parser::deleteElement(const std::string &path)
+bool Parser::deleteElement(const std::string &path, std::ostream &err)
 {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::MUTATE);
+
     if (!root)
     {
-        std::cerr << "No JSON structure parsed." << std::endl;
+        err << "No JSON structure parsed." << std::endl;
         return false;
     }
 
     std::vector<std::string> tokens = splitPath(path);
     if (tokens.empty())
     {
-        std::cerr << "Invalid JSON path." << std::endl;
+        err << "Invalid JSON path." << std::endl;
         return false;
     }
 
-    JSONValue *parent = root;
+    JSONValue *parent = root.get();
     std::string lastToken = tokens.back();
     tokens.pop_back();
 
@@ -204,13 +650,13 @@ bool Parser::deleteElement(const std::string &path)
         JSONObject *obj = dynamic_cast<JSONObject *>(parent);
         if (!obj)
         {
-            std::cerr << "Invalid path: " << path << std::endl;
+            err << "Invalid path: " << path << std::endl;
             return false;
         }
         JSONValue *nextValue = obj->getValue(token);
         if (!nextValue)
         {
-            std::cerr << "Path not found: " << path << std::endl;
+            err << "Path not found: " << path << std::endl;
             return false;
         }
         parent = nextValue;
@@ -219,66 +665,66 @@ bool Parser::deleteElement(const std::string &path)
     JSONObject *parentObj = dynamic_cast<JSONObject *>(parent);
     if (!parentObj)
     {
-        std::cerr << "Invalid path: " << path << std::endl;
+        err << "Invalid path: " << path << std::endl;
         return false;
     }
 
     if (!parentObj->getValue(lastToken))
     {
-        std::cerr << "Element not found at path: " << path << std::endl;
+        err << "Element not found at path: " << path << std::endl;
         return false;
     }
 
-    parentObj->removeValue(lastToken);
+    Edit edit{"delete " + path, {}, {}};
+    edit.steps.push_back(EditStep::remove(parentObj, lastToken));
+    addPath(edit, root.get(), tokens);
+    history.perform(std::move(edit));
+    sourceInSync = false;
     return true;
 }
 
-// TODO: FIX
-bool Parser::move(const std::string &fromPath, const std::string &toPath)
+bool Parser::move(const std::string &fromPath, const std::string &toPath, std::ostream &err)
 {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::MUTATE);
+
     if (!root)
     {
-        std::cerr << "No JSON structure parsed." << std::endl;
+        err << "No JSON structure parsed." << std::endl;
         return false;
     }
 
     std::vector<std::string> fromTokens = splitPath(fromPath);
-    JSONValue *parentFrom = root;
-    std::string lastFromToken = fromTokens.back();
-    fromTokens.pop_back();
+    std::vector<std::string> toTokens = splitPath(toPath);
+    if (fromTokens.empty() || toTokens.empty())
+    {
+        err << "Invalid JSON path." << std::endl;
+        return false;
+    }
 
-    for (const std::string &token : fromTokens)
+    if (toTokens.size() >= fromTokens.size() && std::equal(fromTokens.begin(), fromTokens.end(), toTokens.begin()))
     {
-        JSONObject *obj = dynamic_cast<JSONObject *>(parentFrom);
-        if (!obj)
-        {
-            std::cerr << "Invalid 'from' path: " << fromPath << std::endl;
-            return false;
-        }
-        parentFrom = obj->getValue(token);
-        if (!parentFrom)
-        {
-            std::cerr << "Path not found: " << fromPath << std::endl;
-            return false;
-        }
+        err << "Cannot move " << fromPath << " into itself." << std::endl;
+        return false;
     }
 
-    JSONObject *parentFromObj = dynamic_cast<JSONObject *>(parentFrom);
+    std::string lastFromToken = fromTokens.back();
+    fromTokens.pop_back();
+    JSONObject *parentFromObj = findObject(root.get(), fromTokens);
     if (!parentFromObj)
     {
-        std::cerr << "Invalid 'from' path: " << fromPath << std::endl;
+        err << "Invalid 'from' path: " << fromPath << std::endl;
         return false;
     }
 
-    JSONValue *valueToMove = parentFromObj->getValue(lastFromToken);
-    if (!valueToMove)
+    if (!parentFromObj->getValue(lastFromToken))
     {
-        std::cerr << "Element not found at 'from' path: " << fromPath << std::endl;
+        err << "Element not found at 'from' path: " << fromPath << std::endl;
         return false;
     }
 
-    std::vector<std::string> toTokens = splitPath(toPath);
-    JSONValue *parentTo = root;
+    Edit edit{"move " + fromPath + " " + toPath, {}, {}};
+    JSONValue *parentTo = root.get();
     std::string lastToToken = toTokens.back();
     toTokens.pop_back();
 
@@ -287,148 +733,351 @@ bool Parser::move(const std::string &fromPath, const std::string &toPath)
         JSONObject *obj = dynamic_cast<JSONObject *>(parentTo);
         if (!obj)
         {
-            JSONObject *newObj = new JSONObject();
-            dynamic_cast<JSONObject *>(parentTo)->addValue(token, newObj);
-            parentTo = newObj;
+            err << "Invalid 'to' path: " << toPath << std::endl;
+            return false;
         }
-        else
+
+        parentTo = edit.steps.empty() ? obj->getValue(token) : nullptr;
+        if (!parentTo)
         {
-            parentTo = obj->getValue(token);
-            if (!parentTo)
-            {
-                JSONObject *newObj = new JSONObject();
-                obj->addValue(token, newObj);
-                parentTo = newObj;
-            }
+            std::unique_ptr<JSONObject> newObj(new JSONObject());
+            parentTo = newObj.get();
+            edit.steps.push_back(EditStep::insert(obj, token, std::move(newObj)));
         }
     }
 
     JSONObject *parentToObj = dynamic_cast<JSONObject *>(parentTo);
     if (!parentToObj)
     {
-        std::cerr << "Invalid 'to' path: " << toPath << std::endl;
+        err << "Invalid 'to' path: " << toPath << std::endl;
         return false;
     }
 
-    parentToObj->setValue(lastToToken, valueToMove);
-    parentFromObj->removeValue(lastFromToken);
+    // The subtree is relinked, never copied, so moving it costs the same whatever its size.
+    if (parentToObj->getValue(lastToToken))
+    {
+        edit.steps.push_back(EditStep::remove(parentToObj, lastToToken));
+    }
+    edit.steps.push_back(EditStep::move(parentFromObj, lastFromToken, parentToObj, lastToToken));
+    addPath(edit, root.get(), fromTokens);
+    addPath(edit, root.get(), toTokens);
+    history.perform(std::move(edit));
+    sourceInSync = false;
 
-    std::cerr << "Successfully moved value from " << fromPath << " to " << toPath << std::endl;
+    return true;
+}
+
+bool Parser::rename(const std::string &path, const std::string &newKey, std::ostream &err)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::MUTATE);
+
+    if (!root)
+    {
+        err << "No JSON structure parsed." << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> tokens = splitPath(path);
+    if (tokens.empty() || newKey.empty() || newKey.find('/') != std::string::npos)
+    {
+        err << "Invalid JSON path or key." << std::endl;
+        return false;
+    }
+
+    std::string lastToken = tokens.back();
+    tokens.pop_back();
+    JSONObject *parentObj = findObject(root.get(), tokens);
+    if (!parentObj || !parentObj->getValue(lastToken))
+    {
+        err << "Path not found: " << path << std::endl;
+        return false;
+    }
 
+    if (parentObj->getValue(newKey))
+    {
+        err << "Element already exists with key: " << newKey << std::endl;
+        return false;
+    }
+
+    Edit edit{"rename " + path + " " + newKey, {}, {}};
+    edit.steps.push_back(EditStep::rename(parentObj, lastToken, newKey));
+    addPath(edit, root.get(), tokens);
+    history.perform(std::move(edit));
+    sourceInSync = false;
     return true;
 }
 
-bool Parser::save(const std::string &currPath, const std::string &filePath, const std::string &path)
+size_t Parser::diff(const JSONValue *target, std::ostream &out) const
 {
+    std::shared_lock<std::shared_mutex> lock(mutex);
     if (!root)
     {
         std::cerr << "No JSON structure parsed." << std::endl;
-        return false;
+        return 0;
     }
+    return Differ::diff(root.get(), target, out);
+}
 
-    std::string targetFile = filePath.empty() ? currPath : filePath;
+bool Parser::patch(std::unique_ptr<JSONValue> operations, const std::string &description, std::ostream &err)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::MUTATE);
 
-    if (targetFile.empty())
+    if (!root)
     {
-        std::cerr << "No file path specified." << std::endl;
+        err << "No JSON structure parsed." << std::endl;
         return false;
     }
 
-    JSONValue *target = root;
-    if (!path.empty())
+    if (!operations || operations->getType() != JSONValueType::ARRAY)
     {
-        std::vector<std::string> tokens = splitPath(path);
-        target = navigateToPath(root, tokens);
-        if (!target)
+        err << "A JSON Patch must be an array of operations." << std::endl;
+        return false;
+    }
+
+    Edit edit{description, {}, {}};
+    const auto &list = static_cast<JSONArray *>(operations.get())->getValues();
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        try
         {
-            std::cerr << "Path not found: " << path << std::endl;
+            if (list[i]->getType() != JSONValueType::OBJECT)
+            {
+                throw std::runtime_error("not an object");
+            }
+            applyOperation(static_cast<JSONObject *>(list[i].get()), edit);
+        }
+        catch (const std::runtime_error &e)
+        {
+            History::revert(edit);
+            err << "Patch operation " << i << " failed: " << e.what() << std::endl;
             return false;
         }
     }
 
-    std::ofstream outFile(targetFile);
-    if (!outFile.is_open())
+    // A patch of tests alone changes nothing and leaves nothing to undo.
+    if (!edit.steps.empty())
     {
-        std::cerr << "Could not open file to write: " << targetFile << std::endl;
-        return false;
+        history.record(std::move(edit));
+        sourceInSync = false;
     }
-
-    writeJSON(outFile, target, 0);
-    outFile.close();
-
     return true;
 }
 
-bool Parser::saveas(const std::string &currPath, const std::string &newFilePath, const std::string &path)
+std::string Parser::undo()
 {
-    return save(currPath, newFilePath, path);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::MUTATE);
+    sourceInSync = false;
+    return history.undo();
 }
 
-bool Parser::containsHelper(JSONValue *jsonValue, const std::string &value)
+std::string Parser::redo()
 {
-    switch (jsonValue->getType())
-    {
-    case JSONValueType::STRING:
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::MUTATE);
+    sourceInSync = false;
+    return history.redo();
+}
+
+bool Parser::save(const std::string &currPath, const std::string &filePath, const std::string &path)
+{
+    if (!root)
     {
-        JSONString *jsonString = static_cast<JSONString *>(jsonValue);
-        return jsonString->toString().find(value) != std::string::npos;
+        std::cerr << "No JSON structure parsed." << std::endl;
+        return false;
     }
-    case JSONValueType::NUMBER:
+
+    std::string targetFile = filePath.empty() ? currPath : filePath;
+
+    if (targetFile.empty())
     {
-        JSONNumber *jsonNumber = static_cast<JSONNumber *>(jsonValue);
-        return jsonNumber->toString() == value;
+        std::cerr << "No file path specified." << std::endl;
+        return false;
     }
-    case JSONValueType::BOOL:
+
+    std::string error;
+    if (!writeFile(targetFile, path, error))
     {
-        JSONBool *jsonBool = static_cast<JSONBool *>(jsonValue);
-        return (jsonBool->toString() == value);
+        std::cerr << error << std::endl;
+        return false;
     }
-    case JSONValueType::OBJECT:
+
+    return true;
+}
+
+bool Parser::saveas(const std::string &currPath, const std::string &newFilePath, const std::string &path)
+{
+    return save(currPath, newFilePath, path);
+}
+
+bool Parser::writeFile(const std::string &filePath, const std::string &path, std::string &error, OutputFormat format) const
+{
+    static std::atomic<unsigned> tempCounter{0};
+    std::string tempFile = filePath + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(tempCounter++);
+
+    try
     {
-        JSONObject *jsonObject = static_cast<JSONObject *>(jsonValue);
-        for (const auto &keyValue : jsonObject->getValues())
+        JSON_STATS_PHASE(Phase::SERIALIZE);
+
+        // Only serializing reads the document, so the lock is held for that
+        // alone; compressing and writing the text do not hold up changes.
+        std::stringstream text;
         {
-            if (containsHelper(keyValue.value, value))
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            if (!root)
+            {
+                error = "No JSON structure parsed.";
+                return false;
+            }
+
+            JSONValue *target = root.get();
+            if (!path.empty())
             {
-                return true;
+                target = navigateToPath(root.get(), splitPath(path));
+                if (!target)
+                {
+                    error = "Path not found: " + path;
+                    return false;
+                }
             }
+            writeJSON(text, target, 0, format);
         }
-        break;
-    }
-    case JSONValueType::ARRAY:
-    {
-        JSONArray *jsonArray = static_cast<JSONArray *>(jsonValue);
-        for (const auto &item : jsonArray->getValues())
+
+        CompressionFormat compression = Compression::forOutput(filePath);
+        std::ofstream outFile(tempFile, std::ios::binary);
+        if (!outFile.is_open())
+        {
+            error = "Could not open file to write: " + filePath;
+            return false;
+        }
+
+        StatCounters counters;
+        if (compression == CompressionFormat::NONE)
+        {
+            outFile << text.rdbuf();
+        }
+        else
         {
-            if (containsHelper(item, value))
+            CompressingBuffer compressing(outFile.rdbuf(), compression);
+            std::ostream compressedOut(&compressing);
+            compressedOut << text.rdbuf();
+            if (!compressing.finish())
             {
-                return true;
+                outFile.setstate(std::ios::badbit);
             }
         }
-        break;
+        JSON_STATS_ADD(counters, bytesWritten, static_cast<uint64_t>(outFile.tellp()));
+        outFile.close();
+        JSON_STATS_PUBLISH(counters);
+
+        if (outFile.fail() || !syncFile(tempFile, filePath) || std::rename(tempFile.c_str(), filePath.c_str()) != 0)
+        {
+            error = "Could not write file: " + filePath + ": " + std::strerror(errno);
+            std::remove(tempFile.c_str());
+            return false;
+        }
     }
-    case JSONValueType::NILL:
+    catch (const std::exception &e)
+    {
+        error = e.what();
+        std::remove(tempFile.c_str());
         return false;
     }
 
-    return false;
+    syncDirectory(filePath);
+    return true;
+}
+
+MemoryUsage Parser::measureMemory() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return MemoryReport::measure(root.get(), lexer.getInputSize(), lexer.getRetainedBytes());
 }
 
-JSONValue *Parser::navigateToPath(JSONValue *current, const std::vector<std::string> &tokens)
+bool Parser::reload(std::string newInput)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    JSON_STATS_PHASE(Phase::PARSE);
+
+    bool incremental = sourceInSync && root && reparseChanged(newInput);
+    if (!incremental)
+    {
+        Lexer newLexer(std::move(newInput));
+        root = parseText(newLexer.getInput());
+        lexer = std::move(newLexer);
+    }
+
+    history.clear();
+    sourceInSync = true;
+    JSON_STATS_PUBLISH(stats);
+    return incremental;
+}
+
+std::unique_ptr<JSONValue> Parser::takeRoot()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    history.clear();
+    return std::move(root);
+}
+
+std::unique_ptr<JSONValue> Parser::parseFile(const std::string &path, size_t maxDepth)
+{
+    JSON_STATS_PHASE(Phase::PARSE);
+
+    ChunkReader reader(path);
+    StatCounters counters;
+    DomSink sink(counters);
+    PushParser<DomSink> parser(sink, maxDepth);
+    std::string chunk;
+    while (reader.next(chunk))
+    {
+        parser.feed(chunk);
+    }
+    parser.finish();
+
+    JSON_STATS_PUBLISH(counters);
+    return sink.takeRoot();
+}
+
+std::unique_ptr<JSONValue> Parser::parseDocument(const std::string &text, size_t maxDepth)
+{
+    JSON_STATS_PHASE(Phase::PARSE);
+    ParseContext context(maxDepth);
+    return context.parse(text);
+}
+
+JSONObject *Parser::findObject(JSONValue *current, const std::vector<std::string> &tokens)
+{
+    for (const std::string &token : tokens)
+    {
+        JSONObject *obj = dynamic_cast<JSONObject *>(current);
+        if (!obj)
+        {
+            return nullptr;
+        }
+        current = obj->getValue(token);
+    }
+
+    return dynamic_cast<JSONObject *>(current);
+}
+
+JSONValue *Parser::navigateToPath(JSONValue *current, const std::vector<std::string> &tokens) const
 {
     for (size_t i = 0; i < tokens.size(); i++)
     {
         if (current->getType() == JSONValueType::OBJECT)
         {
             JSONObject *obj = static_cast<JSONObject *>(current);
-            auto keyValues = obj->getValues();
+            const auto &keyValues = obj->getValues();
             bool found = false;
 
-            for (auto &pair : keyValues)
+            for (const auto &pair : keyValues)
             {
                 if (pair.key == tokens[i])
                 {
-                    current = pair.value;
+                    current = pair.value.get();
                     found = true;
                     break;
                 }
@@ -447,7 +1096,7 @@ JSONValue *Parser::navigateToPath(JSONValue *current, const std::vector<std::str
             {
                 return nullptr;
             }
-            current = arr->getValues()[index];
+            current = arr->getValues()[index].get();
         }
         else
         {
@@ -474,189 +1123,273 @@ std::vector<std::string> Parser::splitPath(const std::string &path)
     return tokens;
 }
 
-JSONValue *Parser::parseNewValue(Lexer &lexer)
-{
-    Token token = lexer.nextToken();
-    switch (token.type)
-    {
-    case TokenType::LEFT_BRACE:
-        return parseObject();
-    case TokenType::LEFT_BRACKET:
-        return parseArray();
-    case TokenType::STRING:
-        return new JSONString(token.value);
-    case TokenType::NUMBER:
-        return new JSONNumber(std::stod(token.value));
-    case TokenType::TRUE:
-        return new JSONBool(true);
-    case TokenType::FALSE:
-        return new JSONBool(false);
-    case TokenType::NULL_TYPE:
-        return new JSONNull();
-    default:
-        throw std::runtime_error("Invalid value provided for setting.");
-    }
-}
-
-void Parser::writeJSON(std::ostream &outFile, JSONValue *value, int indent) const
+bool Parser::reparseChanged(std::string &newInput)
 {
-    std::string indentStr(indent, ' ');
+    const std::string &oldInput = lexer.getInput();
+    size_t prefix = commonPrefix(oldInput, newInput);
+    size_t suffix = commonSuffix(oldInput, newInput, std::min(oldInput.size(), newInput.size()) - prefix);
+    size_t changeEnd = oldInput.size() - suffix;
+    std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(newInput.size()) - static_cast<std::ptrdiff_t>(oldInput.size());
+    if (prefix == oldInput.size() && prefix == newInput.size())
+    {
+        return true;
+    }
 
-    switch (value->getType())
+    // A container encloses the change if its opening bracket comes before the
+    // first changed byte and its closing bracket after the last one.
+    auto encloses = [&](size_t begin, const SourceSpan &span)
     {
-    case JSONValueType::OBJECT:
+        return begin < prefix && changeEnd < begin + span.length;
+    };
+
+    const SourceSpan *rootSpan = spanOf(root.get());
+    if (!rootSpan || !encloses(rootSpan->offset, *rootSpan))
     {
-        outFile << "{\n";
-        JSONObject *obj = static_cast<JSONObject *>(value);
-        const auto &keyValues = obj->getValues();
+        return false;
+    }
 
-        for (size_t i = 0; i < keyValues.size(); ++i)
+    // Descend to the innermost enclosing container, remembering the path to it.
+    // Members are in source order, so only the last container opening before
+    // the change can enclose it, and it is found by binary search.
+    std::vector<std::pair<JSONValue *, size_t>> path;
+    JSONValue *target = root.get();
+    size_t targetBegin = rootSpan->offset;
+    while (true)
+    {
+        size_t low = 0;
+        size_t high = childCount(target);
+        size_t candidate = std::string::npos;
+        while (low < high)
         {
-            outFile << indentStr << "  \"" << keyValues[i].key << "\": ";
-            writeJSON(outFile, keyValues[i].value, indent + 2);
-            if (i < keyValues.size() - 1)
+            size_t mid = low + (high - low) / 2;
+            size_t index = mid;
+            while (index < high && !spanOf(childAt(target, index)))
             {
-                outFile << ",";
+                index++;
             }
-            outFile << "\n";
+
+            if (index < high && targetBegin + spanOf(childAt(target, index))->offset < prefix)
+            {
+                candidate = index;
+                low = index + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+
+        if (candidate == std::string::npos)
+        {
+            break;
+        }
+
+        JSONValue *child = childAt(target, candidate);
+        const SourceSpan *span = spanOf(child);
+        size_t begin = targetBegin + span->offset;
+        if (!encloses(begin, *span))
+        {
+            break;
         }
 
-        outFile << indentStr << "}";
-        break;
+        path.push_back({target, candidate});
+        target = child;
+        targetBegin = begin;
+    }
+
+    SourceSpan span = *spanOf(target);
+    span.length += delta;
+    std::unique_ptr<JSONValue> replacement;
+    try
+    {
+        replacement = parseText(newInput.substr(targetBegin, span.length), path.size());
+        if (!spanOf(replacement.get()))
+        {
+            return false;
+        }
     }
-    case JSONValueType::ARRAY:
+    catch (const std::runtime_error &)
     {
-        outFile << "[\n";
-        JSONArray *arr = static_cast<JSONArray *>(value);
-        const auto &values = arr->getValues();
+        return false;
+    }
+    setSpanOf(replacement.get(), span);
 
-        for (size_t i = 0; i < values.size(); ++i)
+    // Every enclosing container grows by delta, and the containers after the
+    // changed one within each of them move by delta. Their contents change,
+    // so their cached hashes are dropped too.
+    for (const auto &step : path)
+    {
+        JSONValue *ancestor = step.first;
+        ancestor->invalidateHash();
+        SourceSpan ancestorSpan = *spanOf(ancestor);
+        ancestorSpan.length += delta;
+        setSpanOf(ancestor, ancestorSpan);
+
+        size_t count = childCount(ancestor);
+        for (size_t i = step.second + 1; i < count; i++)
         {
-            outFile << indentStr << "  ";
-            writeJSON(outFile, values[i], indent + 2);
-            if (i < values.size() - 1)
+            JSONValue *sibling = childAt(ancestor, i);
+            const SourceSpan *siblingSpan = spanOf(sibling);
+            if (siblingSpan)
             {
-                outFile << ",";
+                setSpanOf(sibling, {siblingSpan->offset + delta, siblingSpan->length});
             }
-            outFile << "\n";
         }
-
-        outFile << indentStr << "]";
-        break;
     }
-    case JSONValueType::STRING:
+
+    if (path.empty())
     {
-        JSONString *str = static_cast<JSONString *>(value);
-        outFile << str->toString();
-        break;
+        root = std::move(replacement);
     }
-    case JSONValueType::NUMBER:
+    else if (path.back().first->getType() == JSONValueType::OBJECT)
     {
-        JSONNumber *num = static_cast<JSONNumber *>(value);
-        outFile << num->toString();
-        break;
+        static_cast<JSONObject *>(path.back().first)->replaceValueAt(path.back().second, std::move(replacement));
     }
-    case JSONValueType::BOOL:
+    else
     {
-        JSONBool *boolean = static_cast<JSONBool *>(value);
-        outFile << boolean->toString();
-        break;
+        static_cast<JSONArray *>(path.back().first)->replaceValue(path.back().second, std::move(replacement));
     }
-    case JSONValueType::NILL:
+
+    lexer = Lexer(std::move(newInput));
+    return true;
+}
+
+std::unique_ptr<JSONValue> Parser::parseNewValue(const std::string &text)
+{
+    try
     {
-        outFile << "null";
-        break;
+        return parseText(text);
     }
+    catch (const std::runtime_error &)
+    {
+        throw std::runtime_error("Invalid value provided for setting.");
     }
 }
 
-JSONValue *Parser::parseValue()
+std::string Parser::currentText() const
+{
+    std::ostringstream text;
+    writeJSON(text, root.get());
+    return text.str();
+}
+
+void Parser::writeJSON(std::ostream &outFile, JSONValue *value, int indent, OutputFormat format) const
 {
-    Token token = lexer.nextToken();
-    switch (token.type)
+    if (format == OutputFormat::CANONICAL)
     {
-    case TokenType::LEFT_BRACE:
-        return parseObject();
-    case TokenType::LEFT_BRACKET:
-        return parseArray();
-    case TokenType::STRING:
-        return new JSONString(token.value);
-    case TokenType::NUMBER:
-        return new JSONNumber(std::stod(token.value));
-    case TokenType::TRUE:
-        return new JSONBool(true);
-    case TokenType::FALSE:
-        return new JSONBool(false);
-    case TokenType::NULL_TYPE:
-        return new JSONNull();
-    default:
-        throw std::runtime_error("Unexpected token: " + token.value);
+        Canonicalizer::write(outFile, value);
+        return;
     }
+    Printer::write(outFile, value, indent);
 }
 
-JSONObject *Parser::parseObject()
+void Parser::applyOperation(JSONObject *operation, Edit &edit)
 {
-    JSONObject *obj = new JSONObject();
-    Token token;
-
-    while (token.type != TokenType::RIGHT_BRACE)
+    const std::string op = operationMember(operation, "op");
+    const std::string path = operationMember(operation, "path");
+    // The containers above a change drop their cached hashes at once, as
+    // later operations may test values inside them.
+    auto perform = [this, &edit](EditStep step, const std::string &pointer)
     {
-        token = lexer.nextToken();
-        if (token.type != TokenType::STRING)
+        edit.steps.push_back(std::move(step));
+        History::applyStep(edit.steps.back());
+        size_t first = edit.containers.size();
+        addPath(edit, root.get(), JSONPointer::parse(pointer));
+        for (size_t i = first; i < edit.containers.size(); i++)
         {
-            delete obj;
-            throw std::runtime_error("Expected string key in object");
+            edit.containers[i]->invalidateHash();
         }
+    };
 
-        std::string key = token.value;
-        token = lexer.nextToken();
-        if (token.type != TokenType::COLON)
+    if (op == "add" || op == "replace" || op == "test")
+    {
+        if (!operation->getValue("value"))
         {
-            delete obj;
-            throw std::runtime_error("Expected ':' after key in object");
+            throw std::runtime_error("missing \"value\" member");
         }
 
-        JSONValue *value = parseValue();
-        if (!value)
+        PatchLocation location = locate(root.get(), path, op == "add");
+        if (op == "test")
         {
-            delete obj;
-            return nullptr;
+            if (!JSONValue::equal(location.value, operation->getValue("value")))
+            {
+                throw std::runtime_error("test failed at " + path);
+            }
+            return;
         }
 
-        obj->addValue(key, value);
-        token = lexer.nextToken();
-        if (token.type != TokenType::COMMA && token.type != TokenType::RIGHT_BRACE)
+        std::unique_ptr<JSONValue> value = operation->detachValue("value");
+        EditStep step = op == "add" ? addStep(location, std::move(value), root) : replaceStep(location, std::move(value), root);
+        perform(std::move(step), path);
+    }
+    else if (op == "remove")
+    {
+        perform(removeStep(locate(root.get(), path, false)), path);
+    }
+    else if (op == "copy")
+    {
+        PatchLocation source = locate(root.get(), operationMember(operation, "from"), false);
+        perform(addStep(locate(root.get(), path, true), JSONValue::copy(source.value), root), path);
+    }
+    else if (op == "move")
+    {
+        const std::string from = operationMember(operation, "from");
+        PatchLocation source = locate(root.get(), from, false);
+        if (path == from)
         {
-            delete obj;
-            throw std::runtime_error("Expected ',' or '}' in object");
+            return;
+        }
+        if (path.compare(0, from.size() + 1, from + "/") == 0)
+        {
+            throw std::runtime_error("cannot move " + from + " into itself");
+        }
+        if (path.empty())
+        {
+            // Everything but the value is dropped, so copying it is as good as relinking.
+            perform(EditStep::replaceRoot(&root, JSONValue::copy(source.value)), path);
+            return;
         }
-    }
 
-    return obj;
-}
+        // The target is located as the document is with the value taken out,
+        // which moves the later elements of an array the value is taken from.
+        EditStep taken = removeStep(source);
+        History::applyStep(taken);
+        PatchLocation target;
+        try
+        {
+            target = locate(root.get(), path, true);
+        }
+        catch (const std::runtime_error &)
+        {
+            History::revertStep(taken);
+            throw;
+        }
+        History::revertStep(taken);
 
-JSONArray *Parser::parseArray()
-{
-    JSONArray *arr = new JSONArray();
-    Token token;
+        // The containers above the source are listed before the value leaves them.
+        size_t first = edit.containers.size();
+        addPath(edit, root.get(), JSONPointer::parse(from));
+        size_t last = edit.containers.size();
 
-    while (token.type != TokenType::RIGHT_BRACKET)
-    {
-        JSONValue *value = parseValue();
-        if (!value)
+        if (target.object && target.value)
         {
-            delete arr;
-            return nullptr;
+            perform(EditStep::remove(target.object, target.key), path);
         }
-        arr->addValue(value);
-
-        token = lexer.nextToken();
-        if (token.type != TokenType::COMMA && token.type != TokenType::RIGHT_BRACKET)
+        perform(EditStep::relink(source.object, source.array, source.key, source.index, target.object, target.array,
+                                 target.key, target.array ? target.index : std::string::npos),
+                path);
+        for (size_t i = first; i < last; i++)
         {
-            delete arr;
-            throw std::runtime_error("Expected ',' or ']' in array");
+            edit.containers[i]->invalidateHash();
         }
     }
+    else
+    {
+        throw std::runtime_error("unknown operation \"" + op + "\"");
+    }
+}
 
-    return arr;
+std::unique_ptr<JSONValue> Parser::parseText(const std::string &text, size_t baseDepth)
+{
+    return context.parse(text, baseDepth);
 }
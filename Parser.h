@@ -1,40 +1,99 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <shared_mutex>
 #include <sstream>
 
+#include "BasicParser.h"
+#include "Canonicalizer.h"
+#include "ChunkReader.h"
+#include "Differ.h"
+#include "DomSink.h"
+#include "ParseContext.h"
+#include "PushParser.h"
 #include "Validator.h"
 #include "Printer.h"
 #include "Searcher.h"
+#include "Stats.h"
+#include "MemoryReport.h"
+#include "History.h"
 
 #include "JSONNull.h"
 
+/**
+ * Enum representing how a document is written to a file.
+ */
+enum class OutputFormat
+{
+    // indented, keys in document order
+    PRETTY,
+    // canonical JSON (RFC 8785), see Canonicalizer
+    CANONICAL
+};
+
 /**
  * Responsible for parsing and manipulation of JSON.
+ *
+ * Any number of threads may use one parser. Reads such as print, search,
+ * contains, diff and validate hold the parser's lock shared, so they run
+ * side by side; changes hold it exclusively and are applied one at a time,
+ * each waiting for the reads in progress. Writing a file holds the lock
+ * shared while the document is serialized, so a change made meanwhile
+ * waits until the text is serialized, but not for it to reach the disk.
+ * The values returned by searchKey are only safe to use while no change is made.
  */
 class Parser
 {
 public:
     /**
      * Creates a parser object by parsing string input into a JSONValue object.
+     *
+     * @param stringInput the JSON text
+     * @param maxDepth maximum nesting depth of objects and arrays
      */
-    Parser(const std::string &stringInput);
+    Parser(const std::string &stringInput, size_t maxDepth = DEFAULT_MAX_DEPTH);
+
+    /**
+     * Creates a parser object by parsing the chunks of a file as they are read.
+     *
+     * @param reader the reader of the file
+     * @param maxDepth maximum nesting depth of objects and arrays
+     */
+    Parser(ChunkReader &reader, size_t maxDepth = DEFAULT_MAX_DEPTH);
 
     ~Parser();
 
     /**
-     * Validates the JSON input.
+     * Validates the JSON input, or the document as it would be written if it
+     * has been changed since it was parsed.
      *
      * @return true if the JSON string is valid
      */
     bool validate();
 
+    /**
+     * Validates the JSON input and checks it against a JSON Schema, both in
+     * one pass over the source text. If the document has been changed since
+     * it was parsed, the source text is out of date and the document is
+     * serialized to be checked instead.
+     *
+     * @param schema the compiled schema
+     * @param error receives the reason if the input is not valid or does not conform
+     *
+     * @return true if the input is valid JSON conforming to the schema
+     */
+    bool validateSchema(const Schema &schema, std::string &error);
+
     /**
      * Parses the string input into a JSONValue object.
      *
-     * @return The JSONValue object
+     * @return The JSONValue object, owned by the caller
      */
     JSONValue *parse();
 
@@ -47,8 +106,21 @@ public:
 
     /**
      * Print the JSON from the root.
+     *
+     * @param out the stream to print to
+     */
+    void print(std::ostream &out);
+
+    /**
+     * Prints part of the JSON, for looking around a document too large to print whole.
+     *
+     * @param path JSON path to the value to print, or empty for the root
+     * @param limits how much of the value to print
+     * @param out the stream to print to
+     *
+     * @return false if there is no value at the path
      */
-    void print();
+    bool print(const std::string &path, const PrintLimits &limits, std::ostream &out);
 
     /**
      * Returns all values at a given key.
@@ -59,6 +131,19 @@ public:
      */
     std::vector<JSONValue *> searchKey(const std::string &key);
 
+    /**
+     * Writes the values at a given key as a JSON array, each one as soon as
+     * it is found, and stops searching once enough have been written.
+     *
+     * @param key key to search values for
+     * @param out the stream to write the values to
+     * @param limit most values to write
+     * @param stoppedEarly if given, receives true if more values than the limit have the key
+     *
+     * @return the number of values written
+     */
+    size_t searchKey(const std::string &key, std::ostream &out, size_t limit = SIZE_MAX, bool *stoppedEarly = nullptr);
+
     /**
      * Returns if a value is present in the root JSON.
      *
@@ -69,43 +154,104 @@ public:
     bool contains(const std::string &value);
 
     /**
-     * Sets a new value at a given JSON path.
+     * Sets a new value at a given JSON path. Setting a value equal to the
+     * current one succeeds without changing the document or its history.
      *
      * @param path JSON path to the target element
      * @param newValue the new value to set
+     * @param changed if given, receives true if the document was changed
+     * @param err the stream failures are reported to
      *
      * @return true if the operation is successful
+     * @throws {std::runtime_error} if the new value is not valid JSON
      */
-    bool set(const std::string &path, const std::string &newValue);
+    bool set(const std::string &path, const std::string &newValue, bool *changed = nullptr,
+             std::ostream &err = std::cerr);
 
     /**
      * Creates a new key-value pair in the root JSON.
      *
      * @param path JSON path to the new element
      * @param newValue the new value to set
+     * @param err the stream failures are reported to
      *
      * @return true if the operation is successful
+     * @throws {std::runtime_error} if the new value is not valid JSON
      */
-    bool create(const std::string &path, const std::string &newValue);
+    bool create(const std::string &path, const std::string &newValue, std::ostream &err = std::cerr);
 
     /**
      * Deletes a key-value pair at a given JSON path.
      *
      * @param path JSON path to the target element
+     * @param err the stream failures are reported to
      *
      * @return true if the operation is successful
      */
-    bool deleteElement(const std::string &path);
+    bool deleteElement(const std::string &path, std::ostream &err = std::cerr);
 
     /**
      * Moves a JSON key-value pair from one JSON path to another.
+     * The value is relinked rather than copied, so the cost does not depend on its size.
      *
      * @param fromPath source JSON path
      * @param toPath destination JSON path
+     * @param err the stream failures are reported to
      *
      * @return true if the operation is successful
      */
-    bool move(const std::string &fromPath, const std::string &toPath);
+    bool move(const std::string &fromPath, const std::string &toPath, std::ostream &err = std::cerr);
+
+    /**
+     * Renames the key of a JSON key-value pair in place, keeping its value and position.
+     *
+     * @param path JSON path to the target element
+     * @param newKey the new key
+     * @param err the stream failures are reported to
+     *
+     * @return true if the operation is successful
+     */
+    bool rename(const std::string &path, const std::string &newKey, std::ostream &err = std::cerr);
+
+    /**
+     * Writes the JSON Patch that turns this document into another one.
+     *
+     * @param target the document to compare with
+     * @param out the stream to write the patch to
+     *
+     * @return the number of operations in the patch
+     */
+    size_t diff(const JSONValue *target, std::ostream &out) const;
+
+    /**
+     * Applies a JSON Patch (RFC 6902) to the document as a single edit that
+     * can be undone. Operations are applied in order, and each one sees the
+     * document as the previous ones left it. Added and replaced values are
+     * taken from the patch rather than copied, and moved values are relinked.
+     * If any operation fails, the document is left unchanged.
+     *
+     * @param operations the patch, an array of operations; the values it adds are taken from it
+     * @param description how the edit is described by undo and redo
+     * @param err the stream failures are reported to
+     *
+     * @return true if the operation is successful
+     */
+    bool patch(std::unique_ptr<JSONValue> operations, const std::string &description,
+               std::ostream &err = std::cerr);
+
+    /**
+     * Reverts the most recent set, create, delete, move, rename or patch.
+     *
+     * @return description of the undone edit, or an empty string if there is nothing to undo
+     */
+    std::string undo();
+
+    /**
+     * Reapplies the most recently undone edit.
+     *
+     * @return description of the redone edit, or an empty string if there is nothing to redo
+     */
+    std::string redo();
 
     /**
      * Saves the current state of the JSON.
@@ -131,8 +277,80 @@ public:
      */
     bool saveas(const std::string &currPath, const std::string &newFilePath, const std::string &path = "");
 
-private:
-    bool containsHelper(JSONValue *jsonValue, const std::string &value);
+    /**
+     * Writes the JSON, or a portion of it by a given JSON path, into a file
+     * without ever leaving a partly written file behind. The text goes to a
+     * temporary file next to the target, which is flushed to disk and then
+     * renamed over the target. The file is gzip or zstd compressed if its
+     * name ends in .gz or .zst, or if the file it replaces is compressed.
+     * May be called from any thread.
+     *
+     * The document is not copied: it is serialized into memory while the
+     * lock is held for reading, and a change made meanwhile waits for that.
+     * Compressing, writing and flushing the text happen after the lock is
+     * released, at the cost of holding the whole text in memory.
+     *
+     * @param filePath the path to the file to write
+     * @param path JSON path to the element to write (optional)
+     * @param error receives the reason if the file could not be written
+     * @param format how to write the JSON
+     *
+     * @return true if the file was written
+     */
+    bool writeFile(const std::string &filePath, const std::string &path, std::string &error,
+                   OutputFormat format = OutputFormat::PRETTY) const;
+
+    /**
+     * Measures the memory used by the parsed JSON and the retained input.
+     *
+     * @return the memory usage broken down by category
+     */
+    MemoryUsage measureMemory() const;
+
+    /**
+     * Replaces the document with a new version of its source text.
+     * If the document has not been changed since it was parsed, only the
+     * smallest object or array enclosing the changed bytes is parsed again
+     * and the rest of the tree is kept. Otherwise the whole text is parsed.
+     * The undo history is cleared. If the text is invalid, the document is left unchanged.
+     *
+     * @param newInput the new JSON text
+     *
+     * @return true if only part of the text had to be parsed
+     * @throws {std::runtime_error} if the text is not valid JSON
+     */
+    bool reload(std::string newInput);
+
+    /**
+     * Hands the parsed root to the caller, leaving the parser without a document.
+     *
+     * @return the root JSONValue
+     */
+    std::unique_ptr<JSONValue> takeRoot();
+
+    /**
+     * Parses a whole file into a tree without keeping its text, decompressing it if needed.
+     *
+     * @param path path to the file
+     * @param maxDepth maximum nesting depth of objects and arrays
+     *
+     * @return the parsed JSONValue
+     * @throws {std::runtime_error} if the file cannot be read or is not valid JSON
+     */
+    static std::unique_ptr<JSONValue> parseFile(const std::string &path, size_t maxDepth = DEFAULT_MAX_DEPTH);
+
+    /**
+     * Parses a JSON text into a tree without keeping the text or any other
+     * state, so any number of threads may call it at once. A thread that
+     * parses many texts saves allocations by keeping a ParseContext instead.
+     *
+     * @param text the JSON text
+     * @param maxDepth maximum nesting depth of objects and arrays
+     *
+     * @return the parsed JSONValue
+     * @throws {std::runtime_error} if the text is not valid JSON
+     */
+    static std::unique_ptr<JSONValue> parseDocument(const std::string &text, size_t maxDepth = DEFAULT_MAX_DEPTH);
 
     /**
      * Splits a given JSON path by '/'.
@@ -141,18 +359,36 @@ private:
      *
      * @return vector of strings, representing each token after split
      */
-    std::vector<std::string> splitPath(const std::string &path);
+    static std::vector<std::string> splitPath(const std::string &path);
 
+    /**
+     * Follows a path of object keys.
+     *
+     * @param current the value to start from
+     * @param tokens the keys to follow
+     *
+     * @return the object at the end of the path, or nullptr if there is none
+     */
+    static JSONObject *findObject(JSONValue *current, const std::vector<std::string> &tokens);
+
+private:
     /**
      * Parses a value, used for an update of an older value.
      *
-     * @param lexer a new Lexer object to handle it
+     * @param text the JSON text of the value
      *
      * @return the new JSONValue
+     * @throws {std::runtime_error} if the text is not valid JSON
      */
-    JSONValue *parseNewValue(Lexer &lexer);
+    std::unique_ptr<JSONValue> parseNewValue(const std::string &text);
+
+    JSONValue *navigateToPath(JSONValue *current, const std::vector<std::string> &tokens) const;
 
-    JSONValue *navigateToPath(JSONValue *current, const std::vector<std::string> &tokens);
+    /**
+     * Serializes the document as it is now, for checks that need its text
+     * after the source text has gone out of date.
+     */
+    std::string currentText() const;
 
     /**
      * Writes JSON into an output file.
@@ -160,34 +396,54 @@ private:
      * @param outFile the file to write JSON to
      * @param value the JSONValue used for source
      * @param indent indentation, starting from zero
+     * @param format how to write the JSON
      */
-    void writeJSON(std::ostream &outFile, JSONValue *value, int indent = 0) const;
+    void writeJSON(std::ostream &outFile, JSONValue *value, int indent = 0, OutputFormat format = OutputFormat::PRETTY) const;
 
-private:
     /**
-     * Parses a JSON value.
+     * Applies one operation of a JSON Patch, adding the steps it took to an edit.
      *
-     * @return the parsed JSONValue
+     * @param operation the operation object; its value is taken from it
+     * @param edit the edit receiving the applied steps
+     *
+     * @throws {std::runtime_error} if the operation is invalid or cannot be applied
      */
-    JSONValue *parseValue();
+    void applyOperation(JSONObject *operation, Edit &edit);
 
+private:
     /**
-     * Parses a JSON object.
+     * Parses a JSON text into a tree. The text must hold exactly one value.
      *
-     * @return the parsed JSONObject
+     * @param text the JSON text
+     * @param baseDepth nesting depth of the position the value is parsed at
+     *
+     * @return the parsed JSONValue
+     * @throws {std::runtime_error} if the text is not valid JSON or nests deeper than maxDepth
      */
-    JSONObject *parseObject();
+    std::unique_ptr<JSONValue> parseText(const std::string &text, size_t baseDepth = 0);
 
     /**
-     * Parses a JSON array.
+     * Parses again only the smallest object or array whose text encloses
+     * every byte that differs between the current source and a new one.
+     * On success the new text becomes the source.
+     *
+     * @param newInput the new JSON text
      *
-     * @return the parsed JSONArray
+     * @return false if no such container exists or its new text is not a
+     *         single valid container; the document is then unchanged
      */
-    JSONArray *parseArray();
+    bool reparseChanged(std::string &newInput);
 
 private:
-    JSONValue *root;
+    std::unique_ptr<JSONValue> root;
     Lexer lexer;
+    size_t maxDepth;
+    StatCounters stats;
+    // parses the document and every value set in it
+    ParseContext context;
+    History history;
+    bool sourceInSync = true;
+    mutable std::shared_mutex mutex;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include "PathExtractor.h"
+
+#include <sstream>
+
+std::unique_ptr<JSONValue> PathExtractor::extract(const std::string &filePath, const std::string &path, size_t maxDepth)
+{
+    ChunkReader chunks(filePath);
+    PathExtractor reader(nullptr, &chunks);
+    return reader.extract(path, maxDepth);
+}
+
+std::unique_ptr<JSONValue> PathExtractor::extract(std::istream &in, const std::string &path, size_t maxDepth)
+{
+    PathExtractor reader(&in, nullptr);
+    return reader.extract(path, maxDepth);
+}
+
+PathExtractor::PathExtractor(std::istream *in, ChunkReader *chunks) : in(in), chunks(chunks)
+{
+    if (in)
+    {
+        buffer.resize(BUFFER_SIZE);
+    }
+}
+
+std::unique_ptr<JSONValue> PathExtractor::extract(const std::string &path, size_t maxDepth)
+{
+    JSON_STATS_PHASE(Phase::SEARCH);
+
+    std::vector<std::string> tokens;
+    std::stringstream ss(path);
+    std::string item;
+    while (std::getline(ss, item, '/'))
+    {
+        if (!item.empty())
+        {
+            tokens.push_back(item);
+        }
+    }
+
+    for (const std::string &token : tokens)
+    {
+        char c = skipWhitespace();
+        bool found = false;
+        if (c == '{')
+        {
+            found = findMember(token);
+        }
+        else if (c == '[' && token.find_first_not_of("0123456789") == std::string::npos)
+        {
+            found = findElement(std::stoul(token));
+        }
+
+        if (!found)
+        {
+            JSON_STATS_ADD(stats, bytesScanned, bufferOffset + pos);
+            JSON_STATS_PUBLISH(stats);
+            return nullptr;
+        }
+    }
+
+    std::string text;
+    skipWhitespace();
+    capture = &text;
+    captureFrom = pos;
+    skipValue();
+    text.append(buffer.data() + captureFrom, pos - captureFrom);
+    capture = nullptr;
+
+    DomSink sink(stats);
+    BasicParser<DomSink> parser(text, maxDepth);
+    parser.parse(sink);
+
+    JSON_STATS_ADD(stats, bytesScanned, bufferOffset + pos);
+    JSON_STATS_PUBLISH(stats);
+    return sink.takeRoot();
+}
+
+bool PathExtractor::findMember(const std::string &key)
+{
+    pos++;
+    char c = skipWhitespace();
+    if (c == '}')
+    {
+        pos++;
+        return false;
+    }
+
+    while (true)
+    {
+        if (c != '"')
+        {
+            fail("Expected string key in object");
+        }
+        bool matches = readString() == key;
+
+        if (skipWhitespace() != ':')
+        {
+            fail("Expected ':' after key in object");
+        }
+        pos++;
+
+        if (matches)
+        {
+            return true;
+        }
+
+        skipValue();
+        if (!nextMember('}'))
+        {
+            return false;
+        }
+        c = skipWhitespace();
+    }
+}
+
+bool PathExtractor::findElement(size_t index)
+{
+    pos++;
+    if (skipWhitespace() == ']')
+    {
+        pos++;
+        return false;
+    }
+
+    for (size_t i = 0; i < index; i++)
+    {
+        skipValue();
+        if (!nextMember(']'))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string PathExtractor::readString()
+{
+    std::string raw;
+    pos++;
+    capture = &raw;
+    captureFrom = pos;
+    skipString();
+    raw.append(buffer.data() + captureFrom, pos - captureFrom);
+    capture = nullptr;
+
+    // Drop the closing quote.
+    raw.pop_back();
+    if (raw.find('\\') == std::string::npos)
+    {
+        return raw;
+    }
+
+    std::string decoded;
+    try
+    {
+        StringCodec::unescape(raw.data(), raw.size(), decoded);
+    }
+    catch (const std::runtime_error &e)
+    {
+        fail(e.what());
+    }
+    return decoded;
+}
+
+void PathExtractor::skipValue()
+{
+    char c = skipWhitespace();
+    if (c == '"')
+    {
+        pos++;
+        skipString();
+        return;
+    }
+
+    if (c == '{' || c == '[')
+    {
+        // Only quotes and brackets matter; whether the brackets pair up is left unchecked.
+        size_t depth = 0;
+        while (true)
+        {
+            if (pos == end && !fill())
+            {
+                fail("Unterminated object or array");
+            }
+
+            const char *data = buffer.data();
+            while (pos < end && !CharClass::isStructural(data[pos]))
+            {
+                pos++;
+            }
+            if (pos == end)
+            {
+                continue;
+            }
+
+            char s = data[pos++];
+            if (s == '"')
+            {
+                skipString();
+            }
+            else if (s == '{' || s == '[')
+            {
+                depth++;
+            }
+            else if (--depth == 0)
+            {
+                return;
+            }
+        }
+    }
+
+    if (c == '\0')
+    {
+        fail("Unexpected end of JSON input");
+    }
+
+    while (true)
+    {
+        c = peek();
+        if (c == '\0' || c == ',' || c == '}' || c == ']' || CharClass::isWhitespace(c))
+        {
+            return;
+        }
+        pos++;
+    }
+}
+
+void PathExtractor::skipString()
+{
+    while (true)
+    {
+        if (pos == end && !fill())
+        {
+            fail("Unterminated string");
+        }
+
+        pos += StringCodec::findSpecial(buffer.data() + pos, end - pos);
+        if (pos == end)
+        {
+            continue;
+        }
+
+        char c = buffer[pos++];
+        if (c == '"')
+        {
+            return;
+        }
+        if (c == '\\')
+        {
+            if (pos == end && !fill())
+            {
+                fail("Unterminated string");
+            }
+            pos++;
+        }
+    }
+}
+
+bool PathExtractor::nextMember(char close)
+{
+    char c = skipWhitespace();
+    if (c == ',')
+    {
+        pos++;
+        return true;
+    }
+    if (c != close)
+    {
+        fail(close == '}' ? "Expected ',' or '}' in object" : "Expected ',' or ']' in array");
+    }
+    pos++;
+    return false;
+}
+
+char PathExtractor::peek()
+{
+    if (pos == end && !fill())
+    {
+        return '\0';
+    }
+    return buffer[pos];
+}
+
+char PathExtractor::skipWhitespace()
+{
+    char c = peek();
+    while (CharClass::isWhitespace(c))
+    {
+        pos++;
+        c = peek();
+    }
+    return c;
+}
+
+bool PathExtractor::fill()
+{
+    if (capture)
+    {
+        capture->append(buffer.data() + captureFrom, end - captureFrom);
+        captureFrom = 0;
+    }
+
+    bufferOffset += end;
+    pos = 0;
+    if (chunks)
+    {
+        try
+        {
+            end = chunks->next(buffer) ? buffer.size() : 0;
+        }
+        catch (const std::runtime_error &e)
+        {
+            fail(e.what());
+        }
+        return end > 0;
+    }
+
+    in->read(&buffer[0], static_cast<std::streamsize>(buffer.size()));
+    end = static_cast<size_t>(in->gcount());
+    if (in->bad())
+    {
+        fail("Could not read input");
+    }
+    return end > 0;
+}
+
+void PathExtractor::fail(const std::string &message) const
+{
+    throw std::runtime_error(message + " at offset " + std::to_string(bufferOffset + pos));
+}
@@ -0,0 +1,149 @@
+#ifndef PATH_EXTRACTOR_H
+#define PATH_EXTRACTOR_H
+
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BasicParser.h"
+#include "ChunkReader.h"
+#include "DomSink.h"
+
+/**
+ * Reads the value at one JSON path without parsing the whole document.
+ *
+ * The input is streamed through a fixed-size buffer. At every level, members
+ * whose key is not the next segment of the path are skipped by matching
+ * brackets and quotes, without creating any values, and reading stops as
+ * soon as the target has been read. Only the target is parsed into a tree,
+ * so the cost depends on where the target lies rather than on the size of
+ * the document, and memory use on the size of the target alone.
+ * Skipped members are not validated. Compressed files are decompressed
+ * as they are read.
+ */
+class PathExtractor
+{
+public:
+    /**
+     * Reads the value at a JSON path from a file.
+     *
+     * @param filePath the path to the JSON file
+     * @param path JSON path to the value; array elements are selected by index
+     * @param maxDepth maximum nesting depth of the value
+     *
+     * @return the value, or nullptr if the path does not exist
+     * @throws {std::runtime_error} if the file cannot be read or is not valid JSON on the way to the value
+     */
+    static std::unique_ptr<JSONValue> extract(const std::string &filePath, const std::string &path,
+                                              size_t maxDepth = DEFAULT_MAX_DEPTH);
+
+    /**
+     * Reads the value at a JSON path from a stream.
+     *
+     * @param in the stream holding the JSON document
+     * @param path JSON path to the value; array elements are selected by index
+     * @param maxDepth maximum nesting depth of the value
+     *
+     * @return the value, or nullptr if the path does not exist
+     * @throws {std::runtime_error} if the document is not valid JSON on the way to the value
+     */
+    static std::unique_ptr<JSONValue> extract(std::istream &in, const std::string &path,
+                                              size_t maxDepth = DEFAULT_MAX_DEPTH);
+
+private:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    /**
+     * Creates a reader taking its input from either a stream or a chunk reader.
+     */
+    PathExtractor(std::istream *in, ChunkReader *chunks);
+
+    /**
+     * Moves along a JSON path and parses the value it leads to.
+     *
+     * @return the value, or nullptr if the path does not exist
+     */
+    std::unique_ptr<JSONValue> extract(const std::string &path, size_t maxDepth);
+
+    /**
+     * Moves to the member of the object starting at the current position
+     * with the given key, leaving the position at its value.
+     *
+     * @return false if the object has no such member
+     */
+    bool findMember(const std::string &key);
+
+    /**
+     * Moves to the element of the array starting at the current position
+     * with the given index, leaving the position at its value.
+     *
+     * @return false if the array has fewer elements
+     */
+    bool findElement(size_t index);
+
+    /**
+     * Reads and decodes the string starting at the current position.
+     */
+    std::string readString();
+
+    /**
+     * Moves past the value starting at the current position.
+     */
+    void skipValue();
+
+    /**
+     * Moves past the rest of a string whose opening quote has been read.
+     */
+    void skipString();
+
+    /**
+     * Moves past the separator after a member, and reports whether another member follows.
+     *
+     * @param close the bracket that ends the container
+     *
+     * @return false if the container has ended
+     */
+    bool nextMember(char close);
+
+    /**
+     * Returns the character at the current position, reading more input
+     * if needed, or '\0' at the end of the input.
+     */
+    char peek();
+
+    /**
+     * Skips whitespace and returns the character after it, or '\0' at the end of the input.
+     */
+    char skipWhitespace();
+
+    /**
+     * Refills the buffer, appending what the current capture has not taken yet.
+     *
+     * @return false at the end of the input
+     */
+    bool fill();
+
+    /**
+     * Throws a std::runtime_error with a message and the current offset.
+     *
+     * @param message message to display in the error
+     */
+    [[noreturn]] void fail(const std::string &message) const;
+
+private:
+    std::istream *in;
+    ChunkReader *chunks;
+    std::string buffer;
+    size_t pos = 0;
+    size_t end = 0;
+    size_t bufferOffset = 0;
+
+    // Receives the bytes from captureFrom onwards while a value is being read.
+    std::string *capture = nullptr;
+    size_t captureFrom = 0;
+
+    StatCounters stats;
+};
+
+#endif
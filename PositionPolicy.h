@@ -0,0 +1,76 @@
+#ifndef POSITION_POLICY_H
+#define POSITION_POLICY_H
+
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * Position policy that keeps the line and column up to date while parsing,
+ * so that a sink can ask for the position of every event cheaply.
+ */
+class TrackPosition
+{
+public:
+    /**
+     * Called for every whitespace character the parser skips.
+     *
+     * @param c the character
+     * @param pos offset of the character in the input
+     */
+    void whitespace(char c, size_t pos)
+    {
+        if (c == '\n')
+        {
+            line++;
+            lineStart = pos + 1;
+        }
+    }
+
+    /**
+     * Returns the line of an offset the parser has reached.
+     */
+    size_t getLine(const char *, size_t) const
+    {
+        return line;
+    }
+
+    /**
+     * Returns the column of an offset the parser has reached, counted in bytes.
+     */
+    size_t getColumn(const char *, size_t pos) const
+    {
+        return pos - lineStart + 1;
+    }
+
+private:
+    size_t line = 1;
+    size_t lineStart = 0;
+};
+
+/**
+ * Position policy that does no work while parsing. Positions are recovered
+ * from the input only when asked for, which costs a scan of everything
+ * before the offset, so it suits uses that need a position only for an error.
+ */
+class NoPosition
+{
+public:
+    void whitespace(char, size_t) {}
+
+    size_t getLine(const char *data, size_t pos) const
+    {
+        return 1 + std::count(data, data + pos, '\n');
+    }
+
+    size_t getColumn(const char *data, size_t pos) const
+    {
+        size_t lineStart = pos;
+        while (lineStart > 0 && data[lineStart - 1] != '\n')
+        {
+            lineStart--;
+        }
+        return pos - lineStart + 1;
+    }
+};
+
+#endif
@@ -1,80 +1,177 @@
 #include "Printer.h"
 
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    /**
+     * An object or array whose members are being printed.
+     */
+    struct PrintFrame
+    {
+        const JSONValue *container;
+        size_t index;
+        // members printed are those from begin up to end
+        size_t begin;
+        size_t end;
+        int indentLevel;
+        // levels below the printed value
+        size_t depth;
+    };
+
+    size_t memberCount(const JSONValue *container)
+    {
+        if (container->getType() == JSONValueType::OBJECT)
+        {
+            return static_cast<const JSONObject *>(container)->getValues().size();
+        }
+        return static_cast<const JSONArray *>(container)->getValues().size();
+    }
+}
+
 void Printer::print(const JSONValue *jsonValue, int indentLevel)
+{
+    write(std::cout, jsonValue, indentLevel);
+}
+
+void Printer::write(std::ostream &out, const JSONValue *jsonValue, int indentLevel)
+{
+    write(out, jsonValue, PrintLimits(), indentLevel);
+}
+
+void Printer::write(std::ostream &out, const JSONValue *jsonValue, const PrintLimits &limits, int indentLevel)
+{
+    std::vector<PrintFrame> stack;
+
+    // Prints a value, opening it if it is an object or array to be printed member by member.
+    auto open = [&](const JSONValue *value, int indent, size_t depth, size_t offset)
+    {
+        bool container = value->getType() == JSONValueType::OBJECT || value->getType() == JSONValueType::ARRAY;
+        size_t size = container ? memberCount(value) : 0;
+        if (container && size > 0 && depth >= limits.depth)
+        {
+            bool object = value->getType() == JSONValueType::OBJECT;
+            out << (object ? "{... " : "[... ") << countMembers(size, value) << (object ? "}" : "]");
+            return;
+        }
+        if (!printOpening(out, value))
+        {
+            return;
+        }
+
+        size_t begin = std::min(offset, size);
+        size_t end = size - begin > limits.limit ? begin + limits.limit : size;
+        if (begin > 0)
+        {
+            out << std::string(indent + 2, ' ') << "... " << countMembers(begin, value) << " before\n";
+        }
+        stack.push_back({value, begin, begin, end, indent, depth});
+    };
+
+    open(jsonValue, indentLevel, 0, limits.offset);
+    while (!stack.empty())
+    {
+        PrintFrame &frame = stack.back();
+
+        if (frame.index > frame.begin)
+        {
+            if (frame.index < frame.end)
+            {
+                out << ",";
+            }
+            out << "\n";
+        }
+
+        if (frame.index == frame.end)
+        {
+            size_t size = memberCount(frame.container);
+            if (frame.end < size)
+            {
+                out << std::string(frame.indentLevel + 2, ' ') << "... " << countMembers(size - frame.end, frame.container)
+                    << " after\n";
+            }
+            out << std::string(frame.indentLevel, ' ')
+                << (frame.container->getType() == JSONValueType::OBJECT ? "}" : "]");
+            stack.pop_back();
+            continue;
+        }
+
+        const JSONValue *member;
+        out << std::string(frame.indentLevel + 2, ' ');
+        if (frame.container->getType() == JSONValueType::OBJECT)
+        {
+            const KeyValue &keyValue = static_cast<const JSONObject *>(frame.container)->getValues()[frame.index];
+            StringCodec::writeQuoted(out, keyValue.key);
+            out << ": ";
+            member = keyValue.value.get();
+        }
+        else
+        {
+            member = static_cast<const JSONArray *>(frame.container)->getValues()[frame.index].get();
+        }
+        frame.index++;
+
+        // The arguments are read before open can grow the stack and move the frame.
+        open(member, frame.indentLevel + 2, frame.depth + 1, 0);
+    }
+}
+
+bool Printer::printOpening(std::ostream &out, const JSONValue *jsonValue)
 {
     switch (jsonValue->getType())
     {
     case JSONValueType::STRING:
-        printString(static_cast<const JSONString *>(jsonValue));
+        printString(out, static_cast<const JSONString *>(jsonValue));
         break;
     case JSONValueType::NUMBER:
-        printNumber(static_cast<const JSONNumber *>(jsonValue));
+        printNumber(out, static_cast<const JSONNumber *>(jsonValue));
         break;
     case JSONValueType::BOOL:
-        printBool(static_cast<const JSONBool *>(jsonValue));
+        printBool(out, static_cast<const JSONBool *>(jsonValue));
         break;
     case JSONValueType::OBJECT:
-        printObject(static_cast<const JSONObject *>(jsonValue), indentLevel);
-        break;
+        out << "{\n";
+        return true;
     case JSONValueType::ARRAY:
-        printArray(static_cast<const JSONArray *>(jsonValue), indentLevel);
-        break;
+        out << "[\n";
+        return true;
     case JSONValueType::NILL:
-        std::cout << "null";
+        out << "null";
         break;
     }
-}
 
-void Printer::printString(const JSONString *jsonString)
-{
-    std::cout << jsonString->toString();
+    return false;
 }
 
-void Printer::printNumber(const JSONNumber *jsonNumber)
+void Printer::printString(std::ostream &out, const JSONString *jsonString)
 {
-    std::cout << jsonNumber->toString();
+    StringCodec::writeQuoted(out, jsonString->getValue());
 }
 
-void Printer::printBool(const JSONBool *jsonBool)
+void Printer::printNumber(std::ostream &out, const JSONNumber *jsonNumber)
 {
-    std::cout << jsonBool->toString();
+    out << jsonNumber->toString();
 }
 
-void Printer::printObject(const JSONObject *jsonObject, int indentLevel)
+void Printer::printBool(std::ostream &out, const JSONBool *jsonBool)
 {
-    std::cout << "{\n";
-    const auto &values = jsonObject->getValues();
-    for (size_t i = 0; i < values.size(); ++i)
-    {
-        std::cout << std::string(indentLevel + 2, ' ') << "\"" << values[i].key << "\": ";
-        print(values[i].value, indentLevel + 2);
-
-        if (i < values.size() - 1)
-        {
-            std::cout << ",";
-        }
-
-        std::cout << "\n";
-    }
-    std::cout << std::string(indentLevel, ' ') << "}";
+    out << jsonBool->toString();
 }
 
-void Printer::printArray(const JSONArray *jsonArray, int indentLevel)
+std::string Printer::countMembers(size_t count, const JSONValue *container)
 {
-    std::string indent(indentLevel, ' ');
-    std::cout << "[\n";
-    const auto &values = jsonArray->getValues();
-    for (size_t i = 0; i < values.size(); ++i)
+    std::string digits = std::to_string(count);
+    std::string result;
+    for (size_t i = 0; i < digits.size(); i++)
     {
-        std::cout << std::string(indentLevel + 2, ' ');
-        print(values[i], indentLevel + 2);
-
-        if (i < values.size() - 1)
+        if (i > 0 && (digits.size() - i) % 3 == 0)
         {
-            std::cout << ",";
+            result += ',';
         }
-
-        std::cout << "\n";
+        result += digits[i];
     }
-    std::cout << std::string(indentLevel, ' ') << "]";
+
+    const char *noun = container->getType() == JSONValueType::OBJECT ? " key" : " item";
+    return result + noun + (count == 1 ? "" : "s");
 }
@@ -1,7 +1,9 @@
 #ifndef PRINTER_H
 #define PRINTER_H
 
+#include <cstdint>
 #include <iostream>
+#include <string>
 
 #include "JSONValue.h"
 #include "JSONString.h"
@@ -9,6 +11,21 @@
 #include "JSONObject.h"
 #include "JSONArray.h"
 #include "JSONBool.h"
+#include "StringCodec.h"
+
+/**
+ * Bounds on how much of a document is printed, so that a part of a huge
+ * document can be looked at without printing all of it.
+ */
+struct PrintLimits
+{
+    // objects and arrays this many levels below the printed value are shown as their size only
+    size_t depth = SIZE_MAX;
+    // most members printed of each object or array; the rest are counted
+    size_t limit = SIZE_MAX;
+    // members of the printed value skipped before the first one printed
+    size_t offset = 0;
+};
 
 /**
  * Class used for printing operations.
@@ -24,43 +41,70 @@ public:
      */
     static void print(const JSONValue *jsonValue, int indentLevel = 0);
 
+    /**
+     * Pretty-prints a JSON value to a stream. Nested objects and arrays are
+     * walked with an explicit stack, so any depth can be printed.
+     *
+     * @param out the stream to print to
+     * @param jsonValue the JSON value to print
+     * @param indentLevel indentation level for pretty-printing (starts at 0)
+     */
+    static void write(std::ostream &out, const JSONValue *jsonValue, int indentLevel = 0);
+
+    /**
+     * Pretty-prints part of a JSON value to a stream. Members that are not
+     * printed are counted in their place, as in [... 1,000,000 items], so
+     * the time taken depends on what is printed, not on the size of the value.
+     *
+     * @param out the stream to print to
+     * @param jsonValue the JSON value to print
+     * @param limits how much of the value to print
+     * @param indentLevel indentation level for pretty-printing (starts at 0)
+     */
+    static void write(std::ostream &out, const JSONValue *jsonValue, const PrintLimits &limits, int indentLevel = 0);
+
 private:
     /**
      * Prints a JSON string.
      *
+     * @param out the stream to print to
      * @param jsonString the JSON string to print
      */
-    static void printString(const JSONString *jsonString);
+    static void printString(std::ostream &out, const JSONString *jsonString);
 
     /**
      * Prints a JSON number.
      *
+     * @param out the stream to print to
      * @param jsonNumber the JSON number to print
      */
-    static void printNumber(const JSONNumber *jsonNumber);
+    static void printNumber(std::ostream &out, const JSONNumber *jsonNumber);
 
     /**
      * Prints a JSON boolean.
      *
+     * @param out the stream to print to
      * @param jsonBool the JSON boolean to print
      */
-    static void printBool(const JSONBool *jsonBool);
+    static void printBool(std::ostream &out, const JSONBool *jsonBool);
 
     /**
-     * Pretty-prints a JSON object.
+     * Prints the opening of an object or array, or a whole scalar value.
      *
-     * @param jsonObject the JSON object to print
-     * @param indentLevel indentation level for pretty-printing
+     * @param out the stream to print to
+     * @param jsonValue the JSON value to print
+     *
+     * @return true if the value is an object or array whose members still have to be printed
      */
-    static void printObject(const JSONObject *jsonObject, int indentLevel);
+    static bool printOpening(std::ostream &out, const JSONValue *jsonValue);
 
     /**
-     * Prints a JSON string.
+     * Returns a count of the members of an object or array, such as "1,000,000 items" or "1 key".
      *
-     * @param jsonArray the JSON array to print
-     * @param indentLevel indentation level for pretty-printing
+     * @param count the number of members
+     * @param container the object or array they belong to
      */
-    static void printArray(const JSONArray *jsonArray, int indentLevel);
+    static std::string countMembers(size_t count, const JSONValue *container);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,485 @@
+#ifndef PUSH_PARSER_H
+#define PUSH_PARSER_H
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Lexer.h"
+
+/**
+ * A parser that is given its input in chunks of any size as they arrive,
+ * for reading from pipes and other sources that cannot be read whole up
+ * front. It is a state machine that suspends wherever a chunk ends, even
+ * within a string or number, and resumes with the next chunk.
+ *
+ * Events go to a sink with the same members as for BasicParser, with
+ * offsets counted from the start of the whole input. Apart from the sink,
+ * memory use is bounded by the nesting depth and the longest string or
+ * number, not by the size of the input.
+ */
+template <typename Sink>
+class PushParser
+{
+public:
+    /**
+     * Creates a parser that sends the events of one JSON value to a sink.
+     *
+     * @param sink the sink to receive the events
+     * @param maxDepth maximum nesting depth of objects and arrays
+     */
+    PushParser(Sink &sink, size_t maxDepth = DEFAULT_MAX_DEPTH) : sink(sink), maxDepth(maxDepth) {}
+
+    /**
+     * Parses the next chunk of input. The chunk may end anywhere.
+     * After an error, the parser must not be used again.
+     *
+     * @param data the bytes of the chunk
+     * @param size number of bytes in the chunk
+     *
+     * @throws {std::runtime_error} if the input so far is not valid JSON or nests deeper than maxDepth
+     */
+    void feed(const char *data, size_t size)
+    {
+        size_t pos = 0;
+        while (pos < size)
+        {
+            switch (state)
+            {
+            case State::STRING:
+                pos = continueString(data, size, pos);
+                break;
+            case State::NUMBER:
+            case State::KEYWORD:
+                pos = continueRun(data, size, pos);
+                break;
+            default:
+                pos = structural(data, size, pos);
+                break;
+            }
+        }
+        offset += size;
+    }
+
+    /**
+     * Parses the next chunk of input.
+     *
+     * @param chunk the bytes of the chunk
+     */
+    void feed(const std::string &chunk)
+    {
+        feed(chunk.data(), chunk.size());
+    }
+
+    /**
+     * Ends the input.
+     *
+     * @throws {std::runtime_error} if the input ends before the value is complete
+     */
+    void finish()
+    {
+        if (state == State::NUMBER || state == State::KEYWORD)
+        {
+            finishRun(token);
+        }
+
+        if (state != State::DONE)
+        {
+            fail(state == State::STRING ? "Unterminated string" : "Unexpected end of JSON input", offset);
+        }
+
+        JSON_STATS_ADD(stats, bytesScanned, offset);
+        JSON_STATS_PUBLISH(stats);
+    }
+
+    /**
+     * Returns true once a complete value has been parsed. Only whitespace may follow it.
+     */
+    bool isComplete() const
+    {
+        return state == State::DONE;
+    }
+
+private:
+    /**
+     * What the parser expects next.
+     */
+    enum class State
+    {
+        VALUE,
+        ARRAY_FIRST,
+        OBJECT_FIRST,
+        KEY,
+        COLON,
+        AFTER_VALUE,
+        STRING,
+        NUMBER,
+        KEYWORD,
+        DONE
+    };
+
+    /**
+     * Skips whitespace and handles the character after it, outside of strings, numbers and keywords.
+     *
+     * @return the position after what was consumed
+     */
+    size_t structural(const char *data, size_t size, size_t pos)
+    {
+        while (CharClass::isWhitespace(data[pos]))
+        {
+            if (data[pos] == '\n')
+            {
+                line++;
+                lineStart = offset + pos + 1;
+            }
+            if (++pos == size)
+            {
+                return pos;
+            }
+        }
+
+        char c = data[pos];
+        switch (state)
+        {
+        case State::ARRAY_FIRST:
+            if (c == ']')
+            {
+                return closeContainer(pos);
+            }
+            return startValue(c, pos);
+        case State::VALUE:
+            return startValue(c, pos);
+        case State::OBJECT_FIRST:
+            if (c == '}')
+            {
+                return closeContainer(pos);
+            }
+            return startKey(c, pos);
+        case State::KEY:
+            return startKey(c, pos);
+        case State::COLON:
+            if (c != ':')
+            {
+                fail("Expected ':' after key in object", offset + pos);
+            }
+            JSON_STATS_ADD(stats, tokensProduced, 1);
+            state = State::VALUE;
+            return pos + 1;
+        case State::AFTER_VALUE:
+        {
+            bool isObject = stack.back();
+            if (c == ',')
+            {
+                JSON_STATS_ADD(stats, tokensProduced, 1);
+                state = isObject ? State::KEY : State::VALUE;
+                return pos + 1;
+            }
+            if (c != (isObject ? '}' : ']'))
+            {
+                fail(isObject ? "Expected ',' or '}' in object" : "Expected ',' or ']' in array", offset + pos);
+            }
+            return closeContainer(pos);
+        }
+        default:
+            fail("Unexpected characters at the end of JSON input", offset + pos);
+        }
+    }
+
+    /**
+     * Starts the value beginning with a character.
+     *
+     * @return the position after what was consumed
+     */
+    size_t startValue(char c, size_t pos)
+    {
+        tokenStart = offset + pos;
+        if (c == '{' || c == '[')
+        {
+            if (stack.size() >= maxDepth)
+            {
+                fail("Maximum nesting depth of " + std::to_string(maxDepth) + " exceeded", tokenStart);
+            }
+
+            bool isObject = c == '{';
+            JSON_STATS_ADD(stats, tokensProduced, 1);
+            if (isObject)
+            {
+                sink.startObject(tokenStart);
+            }
+            else
+            {
+                sink.startArray(tokenStart);
+            }
+            stack.push_back(isObject);
+            state = isObject ? State::OBJECT_FIRST : State::ARRAY_FIRST;
+            return pos + 1;
+        }
+
+        token.clear();
+        if (c == '"')
+        {
+            startString(false);
+            return pos + 1;
+        }
+        if (CharClass::isDigit(c) || c == '-')
+        {
+            state = State::NUMBER;
+            return pos;
+        }
+        if (CharClass::isAlpha(c))
+        {
+            state = State::KEYWORD;
+            return pos;
+        }
+        fail("Unexpected character", tokenStart);
+    }
+
+    /**
+     * Starts the object key beginning with a character.
+     *
+     * @return the position after what was consumed
+     */
+    size_t startKey(char c, size_t pos)
+    {
+        if (c != '"')
+        {
+            fail("Expected string key in object", offset + pos);
+        }
+        tokenStart = offset + pos;
+        token.clear();
+        startString(true);
+        return pos + 1;
+    }
+
+    void startString(bool key)
+    {
+        stringIsKey = key;
+        escaped = false;
+        escapePending = false;
+        state = State::STRING;
+    }
+
+    /**
+     * Closes the object or array whose closing bracket is at a position.
+     *
+     * @return the position after the bracket
+     */
+    size_t closeContainer(size_t pos)
+    {
+        JSON_STATS_ADD(stats, tokensProduced, 1);
+        bool isObject = stack.back();
+        stack.pop_back();
+        if (isObject)
+        {
+            sink.endObject(offset + pos + 1);
+        }
+        else
+        {
+            sink.endArray(offset + pos + 1);
+        }
+        valueDone();
+        return pos + 1;
+    }
+
+    void valueDone()
+    {
+        state = stack.empty() ? State::DONE : State::AFTER_VALUE;
+    }
+
+    /**
+     * Reads string contents up to the closing quote or the end of the chunk.
+     *
+     * @return the position after what was consumed
+     */
+    size_t continueString(const char *data, size_t size, size_t pos)
+    {
+        size_t start = pos;
+        if (escapePending)
+        {
+            // The backslash ended the previous chunk; this is the character it escapes.
+            escapePending = false;
+            pos++;
+        }
+
+        while (true)
+        {
+            pos += StringCodec::findSpecial(data + pos, size - pos);
+            if (pos >= size)
+            {
+                token.append(data + start, size - start);
+                return size;
+            }
+
+            char c = data[pos];
+            if (c == '"')
+            {
+                finishString(data + start, pos - start);
+                return pos + 1;
+            }
+            if (c != '\\')
+            {
+                fail("Unescaped control character in string", offset + pos);
+            }
+
+            escaped = true;
+            if (pos + 1 == size)
+            {
+                token.append(data + start, size - start);
+                escapePending = true;
+                return size;
+            }
+            pos += 2;
+        }
+    }
+
+    /**
+     * Completes a string whose last part is given, decoding it and sending it to the sink.
+     */
+    void finishString(const char *data, size_t size)
+    {
+        // A string lying wholly within one chunk is used in place.
+        std::string_view raw(data, size);
+        if (!token.empty())
+        {
+            token.append(data, size);
+            raw = token;
+        }
+
+        size_t invalid = StringCodec::validateUtf8(raw.data(), raw.size());
+        if (invalid != raw.size())
+        {
+            fail("Invalid UTF-8 in string", tokenStart + 1 + invalid);
+        }
+
+        if (escaped)
+        {
+            try
+            {
+                StringCodec::unescape(raw.data(), raw.size(), decoded);
+            }
+            catch (const std::runtime_error &e)
+            {
+                fail(e.what(), tokenStart);
+            }
+            raw = decoded;
+        }
+
+        JSON_STATS_ADD(stats, tokensProduced, 1);
+        if (stringIsKey)
+        {
+            sink.key(raw);
+            state = State::COLON;
+        }
+        else
+        {
+            sink.string(raw);
+            valueDone();
+        }
+    }
+
+    /**
+     * Reads the characters of a number or keyword up to its end or the end of the chunk.
+     *
+     * @return the position after what was consumed
+     */
+    size_t continueRun(const char *data, size_t size, size_t pos)
+    {
+        size_t start = pos;
+        if (state == State::NUMBER)
+        {
+            while (pos < size && CharClass::isNumber(data[pos]))
+            {
+                pos++;
+            }
+        }
+        else
+        {
+            while (pos < size && CharClass::isAlpha(data[pos]))
+            {
+                pos++;
+            }
+        }
+
+        if (pos == size)
+        {
+            token.append(data + start, size - start);
+        }
+        else if (token.empty())
+        {
+            finishRun(std::string_view(data + start, pos - start));
+        }
+        else
+        {
+            token.append(data + start, pos - start);
+            finishRun(token);
+        }
+        return pos;
+    }
+
+    /**
+     * Completes a number or keyword and sends it to the sink.
+     */
+    void finishRun(std::string_view text)
+    {
+        JSON_STATS_ADD(stats, tokensProduced, 1);
+        if (state == State::NUMBER)
+        {
+            if (!CharClass::isValidNumber(text))
+            {
+                fail("Invalid number '" + std::string(text) + "'", tokenStart);
+            }
+            sink.number(text);
+        }
+        else if (text == "true" || text == "false")
+        {
+            sink.boolean(text[0] == 't');
+        }
+        else if (text == "null")
+        {
+            sink.null();
+        }
+        else
+        {
+            fail("Invalid keyword '" + std::string(text) + "'", tokenStart);
+        }
+        valueDone();
+    }
+
+    /**
+     * Throws a std::runtime_error with a message and the position of an offset.
+     *
+     * @param message message to display in the error
+     * @param at offset in the whole input the error is at
+     */
+    [[noreturn]] void fail(const std::string &message, size_t at)
+    {
+        // Strings cannot span lines, so the last line break seen precedes any offset reported.
+        throw std::runtime_error(message + " at line " + std::to_string(line) + ", column " + std::to_string(at - lineStart + 1));
+    }
+
+private:
+    Sink &sink;
+    size_t maxDepth;
+    State state = State::VALUE;
+
+    // true for an open object, false for an open array
+    std::vector<char> stack;
+
+    // offset of the current chunk in the whole input
+    size_t offset = 0;
+    size_t line = 1;
+    size_t lineStart = 0;
+
+    // The part of a string, number or keyword read from earlier chunks.
+    std::string token;
+    size_t tokenStart = 0;
+    std::string decoded;
+    bool stringIsKey = false;
+    bool escaped = false;
+    bool escapePending = false;
+
+    StatCounters stats;
+};
+
+#endif
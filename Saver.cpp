@@ -0,0 +1,118 @@
+#include "Saver.h"
+
+Saver::Saver(Workspace &workspace) : workspace(workspace), worker(&Saver::run, this) {}
+
+Saver::~Saver()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void Saver::save(std::shared_ptr<Parser> parser, const std::string &givenFile, const std::string &path,
+                 OutputFormat format, const void *owner)
+{
+    std::string file = Workspace::canonicalPath(givenFile);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = queue.begin(); it != queue.end(); ++it)
+        {
+            if (it->parser == parser && it->file == file && it->path == path && it->format == format &&
+                it->owner == owner)
+            {
+                queue.erase(it);
+                break;
+            }
+        }
+        queue.push_back({std::move(parser), file, path, format, owner});
+    }
+    wake.notify_one();
+}
+
+bool Saver::isPending(const std::string &givenFile) const
+{
+    std::string file = Workspace::canonicalPath(givenFile);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (busy && inFlight == file)
+    {
+        return true;
+    }
+    for (const Job &job : queue)
+    {
+        if (job.file == file)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Saver::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]()
+              { return queue.empty() && !busy; });
+}
+
+std::vector<SaveResult> Saver::takeResults(const void *owner)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<SaveResult> finished;
+    size_t kept = 0;
+    for (SaveResult &result : results)
+    {
+        if (result.owner == owner)
+        {
+            finished.push_back(std::move(result));
+        }
+        else
+        {
+            results[kept++] = std::move(result);
+        }
+    }
+    results.resize(kept);
+    return finished;
+}
+
+void Saver::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        wake.wait(lock, [this]()
+                  { return stopping || !queue.empty(); });
+        if (queue.empty())
+        {
+            // Only reached when stopping, after the queue has been drained.
+            return;
+        }
+
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        busy = true;
+        inFlight = job.file;
+        lock.unlock();
+
+        SaveResult result{job.file, job.path, false, "", job.owner};
+        result.success = job.parser->writeFile(job.file, job.path, result.error, job.format);
+        // The workspace learns of the new file before the save stops being
+        // pending, so the file is never mistaken for an outside change.
+        if (result.success)
+        {
+            workspace.refresh(job.file, job.parser.get(), job.path.empty() && job.format == OutputFormat::PRETTY);
+        }
+        job.parser.reset();
+
+        lock.lock();
+        results.push_back(std::move(result));
+        busy = false;
+        inFlight.clear();
+        if (queue.empty())
+        {
+            idle.notify_all();
+        }
+    }
+}
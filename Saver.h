@@ -0,0 +1,124 @@
+#ifndef SAVER_H
+#define SAVER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "Workspace.h"
+
+/**
+ * Outcome of a background save.
+ */
+struct SaveResult
+{
+    std::string file;
+    std::string path;
+    bool success;
+    std::string error;
+    // who queued the save
+    const void *owner;
+};
+
+/**
+ * Writes documents to files on a background thread, so that the command
+ * thread does not wait for serialization and disk I/O.
+ *
+ * Every save goes through Parser::writeFile, which replaces the target
+ * atomically and holds the document's lock for reading while it serializes,
+ * so a change made during a save waits for the serialization instead of
+ * corrupting it; it does not wait for the disk. Files are compared by their
+ * canonical path, however they were spelled. A queued save
+ * is dropped when a newer save of the same document to the same file is
+ * queued after it. Pending saves are finished before the saver is destroyed.
+ *
+ * One saver may serve several engines sharing a workspace. Each written
+ * file is reported to the workspace before the save stops being pending,
+ * and the outcome of a save is handed only to whoever queued it.
+ */
+class Saver
+{
+public:
+    /**
+     * Starts the writer thread.
+     *
+     * @param workspace the workspace told about every file written; it must outlive the saver
+     */
+    Saver(Workspace &workspace);
+
+    /**
+     * Finishes all pending saves and stops the writer thread.
+     */
+    ~Saver();
+
+    Saver(const Saver &) = delete;
+    Saver &operator=(const Saver &) = delete;
+
+    /**
+     * Queues a save of a document.
+     *
+     * @param parser the document to save
+     * @param file the path to the file to save to
+     * @param path JSON path to the element to save (optional)
+     * @param format how to write the JSON
+     * @param owner identifies who queued the save, for takeResults
+     */
+    void save(std::shared_ptr<Parser> parser, const std::string &file, const std::string &path = "",
+              OutputFormat format = OutputFormat::PRETTY, const void *owner = nullptr);
+
+    /**
+     * Returns true if a save to the given file is queued or being written.
+     * Once it returns false, the workspace knows the version of the file
+     * that the saves wrote.
+     *
+     * @param file the path to the file
+     */
+    bool isPending(const std::string &file) const;
+
+    /**
+     * Waits until every queued save is written.
+     */
+    void flush();
+
+    /**
+     * Returns the outcome of every save queued by an owner and finished
+     * since the last call for that owner.
+     *
+     * @param owner the owner given to save
+     */
+    std::vector<SaveResult> takeResults(const void *owner = nullptr);
+
+private:
+    /**
+     * A save waiting for the writer thread.
+     */
+    struct Job
+    {
+        std::shared_ptr<Parser> parser;
+        std::string file;
+        std::string path;
+        OutputFormat format;
+        const void *owner;
+    };
+
+    /**
+     * Body of the writer thread.
+     */
+    void run();
+
+private:
+    Workspace &workspace;
+    std::deque<Job> queue;
+    std::string inFlight;
+    bool busy = false;
+    bool stopping = false;
+    std::vector<SaveResult> results;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::thread worker;
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "Schema.h"
+#include "JSONArray.h"
+#include "JSONBool.h"
+#include "JSONObject.h"
+#include "JSONString.h"
+
+#include <stdexcept>
+
+namespace
+{
+    /**
+     * Keywords that constrain a document but are not supported. Checking a
+     * document while ignoring them would accept documents the schema rejects.
+     */
+    const char *const UNSUPPORTED[] = {
+        "$ref", "$dynamicRef", "allOf", "anyOf", "oneOf", "not", "if", "then", "else",
+        "enum", "const", "minimum", "maximum", "exclusiveMinimum", "exclusiveMaximum", "multipleOf",
+        "minLength", "maxLength", "pattern", "minItems", "maxItems", "uniqueItems", "contains",
+        "minContains", "maxContains", "prefixItems", "additionalItems", "unevaluatedItems",
+        "minProperties", "maxProperties", "patternProperties", "propertyNames", "dependencies",
+        "dependentRequired", "dependentSchemas", "unevaluatedProperties"};
+
+    uint8_t typeBit(const std::string &name)
+    {
+        if (name == "string")
+        {
+            return Schema::STRING;
+        }
+        if (name == "number")
+        {
+            return Schema::NUMBER | Schema::INTEGER;
+        }
+        if (name == "integer")
+        {
+            return Schema::INTEGER;
+        }
+        if (name == "boolean")
+        {
+            return Schema::BOOLEAN;
+        }
+        if (name == "null")
+        {
+            return Schema::NULL_TYPE;
+        }
+        if (name == "object")
+        {
+            return Schema::OBJECT;
+        }
+        if (name == "array")
+        {
+            return Schema::ARRAY;
+        }
+        throw std::runtime_error("unknown type \"" + name + "\" in schema");
+    }
+
+    const JSONObject *asObject(const JSONValue *value, const std::string &keyword)
+    {
+        if (value->getType() != JSONValueType::OBJECT)
+        {
+            throw std::runtime_error("\"" + keyword + "\" must be an object in schema");
+        }
+        return static_cast<const JSONObject *>(value);
+    }
+}
+
+Schema::Schema(const JSONValue *schema)
+{
+    nodes.resize(2);
+    nodes[NONE].types = 0;
+
+    std::vector<std::pair<const JSONValue *, size_t>> pending;
+    root = addNode(schema, pending);
+    while (!pending.empty())
+    {
+        std::pair<const JSONValue *, size_t> next = pending.back();
+        pending.pop_back();
+        compileNode(next.first, next.second, pending);
+    }
+}
+
+size_t Schema::getRoot() const
+{
+    return root;
+}
+
+std::string Schema::typeNames(uint8_t types)
+{
+    static const std::pair<uint8_t, const char *> NAMES[] = {
+        {STRING, "string"}, {NUMBER, "number"}, {INTEGER, "integer"}, {BOOLEAN, "boolean"},
+        {NULL_TYPE, "null"}, {OBJECT, "object"}, {ARRAY, "array"}};
+
+    // "number" covers integers too.
+    if (types & NUMBER)
+    {
+        types &= ~INTEGER;
+    }
+
+    std::string result;
+    for (const auto &name : NAMES)
+    {
+        if (types & name.first)
+        {
+            result += (result.empty() ? "" : " or ") + std::string(name.second);
+        }
+    }
+    return result.empty() ? "nothing" : result;
+}
+
+size_t Schema::addNode(const JSONValue *schema, std::vector<std::pair<const JSONValue *, size_t>> &pending)
+{
+    if (schema->getType() == JSONValueType::BOOL)
+    {
+        return static_cast<const JSONBool *>(schema)->getValue() ? ANY : NONE;
+    }
+    if (schema->getType() != JSONValueType::OBJECT)
+    {
+        throw std::runtime_error("a schema must be an object or a boolean");
+    }
+
+    nodes.emplace_back();
+    pending.push_back({schema, nodes.size() - 1});
+    return nodes.size() - 1;
+}
+
+void Schema::compileNode(const JSONValue *schema, size_t index, std::vector<std::pair<const JSONValue *, size_t>> &pending)
+{
+    const JSONObject *object = static_cast<const JSONObject *>(schema);
+    for (const char *keyword : UNSUPPORTED)
+    {
+        if (object->indexOf(keyword) != std::string::npos)
+        {
+            throw std::runtime_error(std::string("schema keyword \"") + keyword + "\" is not supported");
+        }
+    }
+
+    // Nodes are added while this one is read, so it is only reached by index.
+    for (const KeyValue &keyValue : object->getValues())
+    {
+        const std::string &keyword = keyValue.key;
+        const JSONValue *value = keyValue.value.get();
+
+        if (keyword == "type")
+        {
+            uint8_t types = 0;
+            if (value->getType() == JSONValueType::STRING)
+            {
+                types = typeBit(static_cast<const JSONString *>(value)->getValue());
+            }
+            else if (value->getType() == JSONValueType::ARRAY)
+            {
+                for (const auto &name : static_cast<const JSONArray *>(value)->getValues())
+                {
+                    if (name->getType() != JSONValueType::STRING)
+                    {
+                        throw std::runtime_error("\"type\" must list type names in schema");
+                    }
+                    types |= typeBit(static_cast<const JSONString *>(name.get())->getValue());
+                }
+            }
+            else
+            {
+                throw std::runtime_error("\"type\" must be a string or an array in schema");
+            }
+            nodes[index].types = types;
+        }
+        else if (keyword == "properties")
+        {
+            for (const KeyValue &property : asObject(value, keyword)->getValues())
+            {
+                size_t node = addNode(property.value.get(), pending);
+                nodes[index].properties.push_back({property.key, node, false});
+            }
+        }
+        else if (keyword == "additionalProperties")
+        {
+            size_t node = addNode(value, pending);
+            nodes[index].additional = node;
+        }
+        else if (keyword == "items")
+        {
+            if (value->getType() == JSONValueType::ARRAY)
+            {
+                throw std::runtime_error("\"items\" as an array of schemas is not supported");
+            }
+            size_t node = addNode(value, pending);
+            nodes[index].items = node;
+        }
+        else if (keyword == "required" && value->getType() != JSONValueType::ARRAY)
+        {
+            throw std::runtime_error("\"required\" must be an array in schema");
+        }
+    }
+
+    // A required key without a declaration of its own is checked like any undeclared key.
+    Node &node = nodes[index];
+    size_t requiredIndex = object->indexOf("required");
+    if (requiredIndex != std::string::npos)
+    {
+        const JSONValue *required = object->getValues()[requiredIndex].value.get();
+        for (const auto &name : static_cast<const JSONArray *>(required)->getValues())
+        {
+            if (name->getType() != JSONValueType::STRING)
+            {
+                throw std::runtime_error("\"required\" must list key names in schema");
+            }
+
+            const std::string &key = static_cast<const JSONString *>(name.get())->getValue();
+            Property *property = nullptr;
+            for (Property &declared : node.properties)
+            {
+                if (declared.name == key)
+                {
+                    property = &declared;
+                    break;
+                }
+            }
+            if (!property)
+            {
+                node.properties.push_back({key, node.additional, false});
+                property = &node.properties.back();
+            }
+            if (!property->required)
+            {
+                property->required = true;
+                node.requiredCount++;
+            }
+        }
+    }
+
+    // The properties are complete, so views of their names stay valid.
+    for (size_t i = 0; i < node.properties.size(); i++)
+    {
+        node.positions.emplace(node.properties[i].name, i);
+    }
+}
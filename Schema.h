@@ -0,0 +1,135 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "JSONValue.h"
+
+/**
+ * A JSON Schema compiled into a plan that SchemaSink follows while a
+ * document is being parsed, so that a document is checked against its
+ * schema in the same pass that checks its syntax.
+ *
+ * Every subschema becomes a node listing the types it admits, its declared
+ * properties in the order the schema gives them, which of them are
+ * required, and the nodes for undeclared keys and for array elements.
+ * Documents usually list their keys in the order of the schema, so the
+ * sink first compares a key with the property after the previous one and
+ * looks it up by name only when that guess fails.
+ *
+ * The keywords type, properties, required, additionalProperties and items
+ * are supported, as are the boolean schemas true and false. Annotations
+ * such as title or description are ignored. Any other keyword that
+ * constrains a document is rejected when compiling, rather than silently
+ * not being checked.
+ */
+class Schema
+{
+public:
+    /**
+     * Bits for the types a node admits. A number whose text has no fraction
+     * or exponent is an integer; "number" admits every number.
+     */
+    static const uint8_t STRING = 1;
+    static const uint8_t NUMBER = 2;
+    static const uint8_t INTEGER = 4;
+    static const uint8_t BOOLEAN = 8;
+    static const uint8_t NULL_TYPE = 16;
+    static const uint8_t OBJECT = 32;
+    static const uint8_t ARRAY = 64;
+    static const uint8_t ANY_TYPE = 127;
+
+    /**
+     * The node of the schema true, which admits every value.
+     */
+    static const size_t ANY = 0;
+
+    /**
+     * The node of the schema false, which admits no value.
+     */
+    static const size_t NONE = 1;
+
+    /**
+     * A property declared in the properties of a schema.
+     */
+    struct Property
+    {
+        std::string name;
+        size_t node;
+        bool required;
+    };
+
+    /**
+     * A compiled subschema.
+     */
+    struct Node
+    {
+        uint8_t types = ANY_TYPE;
+        std::vector<Property> properties;
+        // positions in properties by name; the views point into properties
+        std::unordered_map<std::string_view, size_t> positions;
+        size_t requiredCount = 0;
+        size_t additional = ANY;
+        size_t items = ANY;
+    };
+
+    /**
+     * Compiles a JSON Schema. Subschemas are compiled with an explicit
+     * stack, so any depth can be compiled.
+     *
+     * @param schema the schema document
+     *
+     * @throws {std::runtime_error} if the schema is malformed or uses a keyword that is not supported
+     */
+    Schema(const JSONValue *schema);
+
+    Schema(const Schema &) = delete;
+    Schema &operator=(const Schema &) = delete;
+
+    /**
+     * Returns the node documents are checked against.
+     */
+    size_t getRoot() const;
+
+    /**
+     * Returns a compiled node.
+     *
+     * @param index the index of the node
+     */
+    const Node &node(size_t index) const
+    {
+        return nodes[index];
+    }
+
+    /**
+     * Returns the names of the types in a set of type bits, such as "string or null".
+     */
+    static std::string typeNames(uint8_t types);
+
+private:
+    /**
+     * Reads the keywords of one subschema into its node, adding a node for
+     * every subschema it contains.
+     *
+     * @param schema the subschema
+     * @param index the index of its node
+     * @param pending receives the subschemas still to be read, with their nodes
+     */
+    void compileNode(const JSONValue *schema, size_t index, std::vector<std::pair<const JSONValue *, size_t>> &pending);
+
+    /**
+     * Returns the node for a subschema: ANY or NONE for a boolean schema,
+     * otherwise a new node that is queued to be read.
+     */
+    size_t addNode(const JSONValue *schema, std::vector<std::pair<const JSONValue *, size_t>> &pending);
+
+private:
+    std::vector<Node> nodes;
+    size_t root;
+};
+
+#endif
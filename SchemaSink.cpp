@@ -0,0 +1,185 @@
+#include "SchemaSink.h"
+#include "JSONPointer.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+SchemaSink::SchemaSink(const Schema &schema) : schema(schema), pending(schema.getRoot()) {}
+
+void SchemaSink::startObject(size_t)
+{
+    if (unchecked > 0)
+    {
+        unchecked++;
+        return;
+    }
+
+    size_t node = next();
+    check(node, Schema::OBJECT);
+    const Schema::Node &compiled = schema.node(node);
+    if (compiled.properties.empty() && compiled.additional == Schema::ANY)
+    {
+        unchecked = 1;
+        return;
+    }
+
+    Frame frame;
+    frame.node = node;
+    frame.isObject = true;
+    frame.seenBegin = seen.size();
+    seen.resize(seen.size() + compiled.properties.size(), false);
+    stack.push_back(std::move(frame));
+}
+
+void SchemaSink::endObject(size_t)
+{
+    if (unchecked > 0)
+    {
+        unchecked--;
+        return;
+    }
+
+    const Frame &frame = stack.back();
+    const Schema::Node &compiled = schema.node(frame.node);
+    if (frame.requiredSeen < compiled.requiredCount)
+    {
+        for (size_t i = 0; i < compiled.properties.size(); i++)
+        {
+            if (compiled.properties[i].required && !seen[frame.seenBegin + i])
+            {
+                fail("missing required key \"" + compiled.properties[i].name + "\"", stack.size() - 1);
+            }
+        }
+    }
+
+    seen.resize(frame.seenBegin);
+    stack.pop_back();
+}
+
+void SchemaSink::startArray(size_t)
+{
+    if (unchecked > 0)
+    {
+        unchecked++;
+        return;
+    }
+
+    size_t node = next();
+    check(node, Schema::ARRAY);
+    if (schema.node(node).items == Schema::ANY)
+    {
+        unchecked = 1;
+        return;
+    }
+
+    Frame frame;
+    frame.node = node;
+    frame.isObject = false;
+    stack.push_back(std::move(frame));
+}
+
+void SchemaSink::endArray(size_t)
+{
+    if (unchecked > 0)
+    {
+        unchecked--;
+        return;
+    }
+    stack.pop_back();
+}
+
+void SchemaSink::key(std::string_view key)
+{
+    if (unchecked > 0)
+    {
+        return;
+    }
+
+    Frame &frame = stack.back();
+    const Schema::Node &compiled = schema.node(frame.node);
+    const auto &properties = compiled.properties;
+
+    // Keys usually come in the order the schema declares them in.
+    size_t position = std::string::npos;
+    if (frame.cursor < properties.size() && properties[frame.cursor].name == key)
+    {
+        position = frame.cursor;
+    }
+    else if (!properties.empty())
+    {
+        auto found = compiled.positions.find(key);
+        if (found != compiled.positions.end())
+        {
+            position = found->second;
+        }
+    }
+
+    frame.member = position;
+    if (position == std::string::npos)
+    {
+        pending = compiled.additional;
+        if (pending == Schema::NONE)
+        {
+            fail("key \"" + std::string(key) + "\" is not allowed", stack.size() - 1);
+        }
+        if (pending != Schema::ANY)
+        {
+            frame.undeclared.assign(key.data(), key.size());
+        }
+        return;
+    }
+
+    frame.cursor = position + 1;
+    pending = properties[position].node;
+    if (!seen[frame.seenBegin + position])
+    {
+        seen[frame.seenBegin + position] = true;
+        frame.requiredSeen += properties[position].required;
+    }
+}
+
+void SchemaSink::mismatch(size_t node, uint8_t type) const
+{
+    uint8_t types = schema.node(node).types;
+    fail(types == 0 ? "no value is allowed" : "expected " + Schema::typeNames(types) + ", found " + Schema::typeNames(type),
+         stack.size());
+}
+
+bool SchemaSink::isInteger(std::string_view text)
+{
+    bool plain = true;
+    for (char c : text)
+    {
+        plain &= c != '.' && c != 'e' && c != 'E';
+    }
+    if (plain)
+    {
+        return true;
+    }
+    double value = std::strtod(std::string(text).c_str(), nullptr);
+    return std::isfinite(value) && std::floor(value) == value;
+}
+
+void SchemaSink::fail(const std::string &message, size_t depth) const
+{
+    std::string pointer;
+    for (size_t i = 0; i < depth; i++)
+    {
+        const Frame &frame = stack[i];
+        if (!frame.isObject)
+        {
+            JSONPointer::append(pointer, std::to_string(frame.count - 1));
+        }
+        else if (frame.member != std::string::npos)
+        {
+            JSONPointer::append(pointer, schema.node(frame.node).properties[frame.member].name);
+        }
+        else
+        {
+            JSONPointer::append(pointer, frame.undeclared);
+        }
+    }
+
+    throw std::runtime_error("Schema violation at " + (pointer.empty() ? std::string("the root") : pointer) + ": " + message);
+}
@@ -0,0 +1,151 @@
+#ifndef SCHEMA_SINK_H
+#define SCHEMA_SINK_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Schema.h"
+
+/**
+ * Sink for BasicParser that checks the document against a compiled Schema
+ * as it is parsed, and builds nothing. A violation is thrown from the event
+ * that reveals it, which stops the parse at once.
+ *
+ * A value the schema leaves unconstrained, such as the value of an
+ * undeclared key when additional properties are allowed, is passed over
+ * by counting its brackets, without looking up any node.
+ */
+class SchemaSink
+{
+public:
+    /**
+     * @param schema the compiled schema; it must outlive the sink
+     */
+    SchemaSink(const Schema &schema);
+
+    void startObject(size_t offset);
+    void endObject(size_t end);
+    void startArray(size_t offset);
+    void endArray(size_t end);
+    void key(std::string_view key);
+
+    void string(std::string_view)
+    {
+        if (unchecked == 0)
+        {
+            check(next(), Schema::STRING);
+        }
+    }
+
+    void number(std::string_view text)
+    {
+        if (unchecked == 0)
+        {
+            // Only a node that admits integers but not all numbers needs the text looked at.
+            size_t node = next();
+            if (!(schema.node(node).types & Schema::NUMBER))
+            {
+                check(node, isInteger(text) ? Schema::INTEGER : Schema::NUMBER);
+            }
+        }
+    }
+
+    void boolean(bool)
+    {
+        if (unchecked == 0)
+        {
+            check(next(), Schema::BOOLEAN);
+        }
+    }
+
+    void null()
+    {
+        if (unchecked == 0)
+        {
+            check(next(), Schema::NULL_TYPE);
+        }
+    }
+
+private:
+    /**
+     * An object or array checked against a node, and the member being read in it.
+     */
+    struct Frame
+    {
+        size_t node;
+        bool isObject;
+        // objects: position of the current key in the node's properties, npos if undeclared
+        size_t member = std::string::npos;
+        // objects: position in properties of the key expected next
+        size_t cursor = 0;
+        // objects: where the seen flags of the node's properties start
+        size_t seenBegin = 0;
+        size_t requiredSeen = 0;
+        // arrays: number of elements so far
+        size_t count = 0;
+        // objects: the current key if it is undeclared
+        std::string undeclared;
+    };
+
+    /**
+     * Returns the node the value starting now is checked against, counting
+     * it if it is an array element.
+     */
+    size_t next()
+    {
+        if (!stack.empty() && !stack.back().isObject)
+        {
+            Frame &frame = stack.back();
+            frame.count++;
+            return schema.node(frame.node).items;
+        }
+        return pending;
+    }
+
+    /**
+     * Checks that a value is of a type its node admits.
+     *
+     * @param node the node the value is checked against
+     * @param type the type bit of the value
+     *
+     * @throws {std::runtime_error} if the type is not admitted
+     */
+    void check(size_t node, uint8_t type) const
+    {
+        if (!(schema.node(node).types & type))
+        {
+            mismatch(node, type);
+        }
+    }
+
+    /**
+     * Throws the violation for a value of a type its node does not admit.
+     */
+    [[noreturn]] void mismatch(size_t node, uint8_t type) const;
+
+    /**
+     * Returns true if a number is an integer: its text has no fraction or
+     * exponent, or they leave no fraction, as in 1.0 or 1e2.
+     */
+    static bool isInteger(std::string_view text);
+
+    /**
+     * Throws a violation, naming the location it was found at.
+     *
+     * @param message what is wrong
+     * @param depth number of open containers whose current member leads to the location
+     */
+    [[noreturn]] void fail(const std::string &message, size_t depth) const;
+
+private:
+    const Schema &schema;
+    std::vector<Frame> stack;
+    std::vector<bool> seen;
+    // node of the value after the current key, or of the root
+    size_t pending;
+    // depth inside a value that is not checked
+    size_t unchecked = 0;
+};
+
+#endif
@@ -1,43 +1,162 @@
 #include "Searcher.h"
+#include "KeyFilter.h"
+
+namespace
+{
+    /**
+     * An object or array whose members are being searched.
+     */
+    struct SearchFrame
+    {
+        const JSONValue *container;
+        size_t index;
+    };
+}
 
 std::vector<JSONValue *> Searcher::searchByKey(const JSONObject *jsonObject, const std::string &key)
 {
     std::vector<JSONValue *> results;
-    searchObject(jsonObject, key, results);
+    searchByKey(jsonObject, key, [&results](JSONValue *value)
+                {
+                    results.push_back(value);
+                    return true;
+                });
     return results;
 }
 
-void Searcher::searchObject(const JSONObject *jsonObject, const std::string &key, std::vector<JSONValue *> &results)
+size_t Searcher::searchByKey(const JSONValue *jsonValue, const std::string &key, const std::function<bool(JSONValue *)> &onMatch)
 {
-    for (const auto &keyValue : jsonObject->getValues())
+    size_t found = 0;
+    StatCounters stats;
+    std::vector<SearchFrame> stack;
+    uint64_t keyHash = KeyFilter::hashKey(key);
+    const KeyFilter *filter = jsonValue->keyFilter();
+    if (filter && filter->mayContain(keyHash))
+    {
+        stack.push_back({jsonValue, 0});
+    }
+
+    while (!stack.empty())
     {
-        if (keyValue.key == key)
+        SearchFrame &frame = stack.back();
+        JSONValue *member;
+
+        if (frame.container->getType() == JSONValueType::OBJECT)
+        {
+            const auto &values = static_cast<const JSONObject *>(frame.container)->getValues();
+            if (frame.index == values.size())
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            const KeyValue &keyValue = values[frame.index++];
+            member = keyValue.value.get();
+            if (keyValue.key == key)
+            {
+                found++;
+                if (!onMatch(member))
+                {
+                    break;
+                }
+            }
+        }
+        else
         {
-            results.push_back(keyValue.value);
+            const auto &values = static_cast<const JSONArray *>(frame.container)->getValues();
+            if (frame.index == values.size())
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            member = values[frame.index++].get();
         }
 
-        if (keyValue.value->getType() == JSONValueType::OBJECT)
+        JSON_STATS_ADD(stats, nodesVisited, 1);
+        JSONValueType type = member->getType();
+        if (type != JSONValueType::OBJECT && type != JSONValueType::ARRAY)
         {
-            searchObject(static_cast<const JSONObject *>(keyValue.value), key, results);
+            continue;
         }
-        else if (keyValue.value->getType() == JSONValueType::ARRAY)
+        // Subtrees whose filter rules the key out are skipped whole.
+        filter = member->keyFilter();
+        if (filter->mayContain(keyHash))
         {
-            searchArray(static_cast<const JSONArray *>(keyValue.value), key, results);
+            stack.push_back({member, 0});
         }
     }
+
+    JSON_STATS_PUBLISH(stats);
+    return found;
 }
 
-void Searcher::searchArray(const JSONArray *jsonArray, const std::string &key, std::vector<JSONValue *> &results)
+bool Searcher::containsValue(const JSONValue *jsonValue, const std::string &value)
 {
-    for (const auto &value : jsonArray->getValues())
+    StatCounters stats;
+    std::vector<const JSONValue *> stack = {jsonValue};
+
+    while (!stack.empty())
     {
-        if (value->getType() == JSONValueType::OBJECT)
+        const JSONValue *current = stack.back();
+        stack.pop_back();
+        JSON_STATS_ADD(stats, nodesVisited, 1);
+
+        switch (current->getType())
+        {
+        case JSONValueType::STRING:
+        {
+            const JSONString *jsonString = static_cast<const JSONString *>(current);
+            if (jsonString->toString().find(value) != std::string::npos)
+            {
+                JSON_STATS_PUBLISH(stats);
+                return true;
+            }
+            break;
+        }
+        case JSONValueType::NUMBER:
         {
-            searchObject(static_cast<const JSONObject *>(value), key, results);
+            const JSONNumber *jsonNumber = static_cast<const JSONNumber *>(current);
+            if (jsonNumber->toString() == value)
+            {
+                JSON_STATS_PUBLISH(stats);
+                return true;
+            }
+            break;
         }
-        else if (value->getType() == JSONValueType::ARRAY)
+        case JSONValueType::BOOL:
         {
-            searchArray(static_cast<const JSONArray *>(value), key, results);
+            const JSONBool *jsonBool = static_cast<const JSONBool *>(current);
+            if (jsonBool->toString() == value)
+            {
+                JSON_STATS_PUBLISH(stats);
+                return true;
+            }
+            break;
+        }
+        case JSONValueType::OBJECT:
+        {
+            const JSONObject *jsonObject = static_cast<const JSONObject *>(current);
+            for (const auto &keyValue : jsonObject->getValues())
+            {
+                stack.push_back(keyValue.value.get());
+            }
+            break;
+        }
+        case JSONValueType::ARRAY:
+        {
+            const JSONArray *jsonArray = static_cast<const JSONArray *>(current);
+            for (const auto &item : jsonArray->getValues())
+            {
+                stack.push_back(item.get());
+            }
+            break;
+        }
+        case JSONValueType::NILL:
+            break;
         }
     }
+
+    JSON_STATS_PUBLISH(stats);
+    return false;
 }
@@ -1,8 +1,14 @@
 #ifndef SEARCHER_H
 #define SEARCHER_H
 
+#include <functional>
+
 #include "JSONObject.h"
 #include "JSONArray.h"
+#include "JSONString.h"
+#include "JSONNumber.h"
+#include "JSONBool.h"
+#include "Stats.h"
 
 /**
  * Provides searching functionality in a JSON value.
@@ -11,7 +17,8 @@ class Searcher
 {
 public:
     /**
-     * Retrieves all values in a JSON object with a given key.
+     * Retrieves all values in a JSON object with a given key, in document order.
+     * Nested objects and arrays are walked with an explicit stack, so any depth can be searched.
      *
      * @param jsonObject the JSON object to search in
      * @param key the key to find values for
@@ -20,24 +27,31 @@ public:
      */
     static std::vector<JSONValue *> searchByKey(const JSONObject *jsonObject, const std::string &key);
 
-private:
     /**
-     * Searches for values with a given key in a JSON object and fills them in a vector.
+     * Hands each value with a given key to a callback as soon as it is
+     * found, in document order, without collecting them first. The search
+     * stops as soon as the callback returns false, so finding the first few
+     * matches costs only the walk up to them. Objects and arrays whose key
+     * filter rules the key out are skipped without being walked.
      *
-     * @param jsonObject the JSON object to search in
+     * @param jsonValue the JSON value to search in
      * @param key the key to find values for
-     * @param results vector of values to fill
+     * @param onMatch called with each value found; returns false to stop the search
+     *
+     * @return the number of values handed to the callback
      */
-    static void searchObject(const JSONObject *jsonObject, const std::string &key, std::vector<JSONValue *> &results);
-    
+    static size_t searchByKey(const JSONValue *jsonValue, const std::string &key, const std::function<bool(JSONValue *)> &onMatch);
+
     /**
-     * Searches for values with a given key in a JSON array and fills them in a vector.
+     * Checks whether a value is present anywhere in a JSON value.
+     * Strings match if they contain the text, numbers and booleans if they equal it.
      *
-     * @param jsonArray the JSON array to search in
-     * @param key the key to find values for
-     * @param results vector of values to fill
+     * @param jsonValue the JSON value to search in
+     * @param value the text to look for
+     *
+     * @return true if the value is present
      */
-    static void searchArray(const JSONArray *jsonArray, const std::string &key, std::vector<JSONValue *> &results);
+    static bool containsValue(const JSONValue *jsonValue, const std::string &value);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,262 @@
+#include "Server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    std::runtime_error socketError(const std::string &what)
+    {
+        return std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    /**
+     * Writes a whole buffer to a socket.
+     *
+     * @return false if the peer has gone away
+     */
+    bool sendAll(int socket, const std::string &data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            ssize_t count = ::send(socket, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (count <= 0)
+            {
+                return false;
+            }
+            sent += static_cast<size_t>(count);
+        }
+        return true;
+    }
+}
+
+Server::Server(const std::string &socketPath, const std::string &initialFile)
+    : workspace(std::make_shared<Workspace>()), saver(std::make_shared<Saver>(*workspace)), socketPath(socketPath),
+      initialFile(initialFile)
+{
+}
+
+Server::~Server()
+{
+    stop();
+    {
+        std::unique_lock<std::mutex> lock(clientsMutex);
+        clientsDone.wait(lock, [this]()
+                         { return activeClients == 0; });
+    }
+    if (listenSocket >= 0)
+    {
+        ::close(listenSocket);
+    }
+    if (bound)
+    {
+        ::unlink(socketPath.c_str());
+    }
+}
+
+void Server::run()
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path is too long: " + socketPath);
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket < 0)
+    {
+        throw socketError("Could not create socket");
+    }
+
+    removeStaleSocket(address);
+    if (::bind(listenSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        throw socketError("Could not bind " + socketPath);
+    }
+    bound = true;
+    if (::listen(listenSocket, SOMAXCONN) < 0)
+    {
+        throw socketError("Could not listen on " + socketPath);
+    }
+
+    // The initial file is parsed before the first client, which then finds it cached.
+    if (!initialFile.empty())
+    {
+        Engine engine(workspace, saver);
+        engine.openFile(initialFile);
+    }
+
+    running = true;
+    std::cout << "Serving on " << socketPath << std::endl;
+
+    while (running)
+    {
+        int client = ::accept(listenSocket, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            if (!running)
+            {
+                break;
+            }
+            throw socketError("Could not accept a client");
+        }
+
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        if (!running)
+        {
+            ::close(client);
+            break;
+        }
+        clients.insert(client);
+        activeClients++;
+        std::thread(&Server::serveClient, this, client).detach();
+    }
+}
+
+void Server::removeStaleSocket(const sockaddr_un &address)
+{
+    struct stat info;
+    if (::lstat(socketPath.c_str(), &info) < 0)
+    {
+        return;
+    }
+    if (!S_ISSOCK(info.st_mode))
+    {
+        throw std::runtime_error("Refusing to replace " + socketPath + ": it is not a socket");
+    }
+
+    // A socket that still accepts connections belongs to a running server.
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0)
+    {
+        throw socketError("Could not create socket");
+    }
+    bool live = ::connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+    ::close(probe);
+    if (live)
+    {
+        throw std::runtime_error("A server is already serving on " + socketPath);
+    }
+    ::unlink(socketPath.c_str());
+}
+
+void Server::serveClient(int client)
+{
+    std::unique_ptr<Engine> engine(new Engine(workspace, saver));
+    if (!initialFile.empty())
+    {
+        std::ostringstream ignored;
+        engine->execute("open " + initialFile, ignored);
+    }
+
+    std::string pending;
+    char buffer[64 * 1024];
+    bool open = true;
+
+    while (open)
+    {
+        ssize_t count = ::recv(client, buffer, sizeof(buffer), 0);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            break;
+        }
+        pending.append(buffer, static_cast<size_t>(count));
+
+        // Answer every complete request received so far in one write, so
+        // that pipelined requests do not wait for each other's round trip.
+        std::string responses;
+        size_t start = 0;
+        size_t end;
+        while (open && (end = pending.find('\n', start)) != std::string::npos)
+        {
+            std::string request = pending.substr(start, end - start);
+            if (!request.empty() && request.back() == '\r')
+            {
+                request.pop_back();
+            }
+            start = end + 1;
+            open = handleRequest(*engine, request, responses);
+        }
+        pending.erase(0, start);
+
+        // A request that never ends would make the buffer grow without bound.
+        if (open && pending.size() > MAX_REQUEST_BYTES)
+        {
+            responses += "Error: request is longer than " + std::to_string(MAX_REQUEST_BYTES) + " bytes.\n";
+            responses += '\0';
+            open = false;
+        }
+
+        if (!sendAll(client, responses))
+        {
+            break;
+        }
+    }
+
+    // The session waits for its saves here, while the server still waits for this thread.
+    engine.reset();
+
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    clients.erase(client);
+    ::close(client);
+    activeClients--;
+    clientsDone.notify_all();
+}
+
+bool Server::handleRequest(Engine &engine, const std::string &request, std::string &response)
+{
+    if (request == "exit")
+    {
+        return false;
+    }
+    if (request == "shutdown")
+    {
+        response += "Shutting down.\n";
+        response += '\0';
+        stop();
+        return false;
+    }
+
+    std::ostringstream out;
+    engine.execute(request, out);
+    response += out.str();
+    response += '\0';
+    return true;
+}
+
+void Server::stop()
+{
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    if (!running.exchange(false))
+    {
+        return;
+    }
+
+    // Wakes up accept and every connection thread blocked in recv.
+    ::shutdown(listenSocket, SHUT_RDWR);
+    for (int client : clients)
+    {
+        ::shutdown(client, SHUT_RD);
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+
+#include <sys/un.h>
+
+#include "Engine.h"
+
+/**
+ * Serves the Engine command language over a Unix domain socket, so that the
+ * loaded documents stay parsed between requests.
+ *
+ * A request is one command terminated by a newline. Its response is the
+ * text the command printed, terminated by a NUL byte. A request longer than
+ * MAX_REQUEST_BYTES is answered with an error and the connection is closed.
+ * Clients may send many requests without waiting; responses come back in the
+ * same order. Every client has its own connection thread and its own Engine
+ * session, with its own current document. The sessions share one workspace
+ * and saver, so a document opened by several clients is parsed once; their
+ * commands run side by side, and changes to a shared document are applied
+ * one at a time.
+ *
+ * Besides the Engine commands, "exit" closes the connection and "shutdown"
+ * stops the server.
+ */
+class Server
+{
+public:
+    static const size_t MAX_REQUEST_BYTES = 16 * 1024 * 1024;
+
+    /**
+     * Constructs a server.
+     *
+     * @param socketPath path of the socket to listen on; a stale socket there is replaced
+     * @param initialFile file every session starts with, or empty for none
+     */
+    Server(const std::string &socketPath, const std::string &initialFile = "");
+
+    ~Server();
+
+    Server(const Server &) = delete;
+    Server &operator=(const Server &) = delete;
+
+    /**
+     * Accepts and serves clients until a client sends "shutdown".
+     *
+     * @throws {std::runtime_error} if the socket cannot be created, or if the
+     * path holds something other than a socket or a server is listening there
+     */
+    void run();
+
+private:
+    /**
+     * Removes a stale socket left at the socket path by a server that is gone.
+     *
+     * @param address the address of the socket path
+     *
+     * @throws {std::runtime_error} if the path holds something other than a
+     * socket, or a server is still listening on it
+     */
+    void removeStaleSocket(const sockaddr_un &address);
+
+    /**
+     * Reads requests from a client and answers them until it disconnects.
+     *
+     * @param client the connected socket
+     */
+    void serveClient(int client);
+
+    /**
+     * Executes one request.
+     *
+     * @param engine the session of the client
+     * @param request the command line
+     * @param response receives the output, terminated by a NUL byte
+     *
+     * @return false if the connection should be closed after the response
+     */
+    bool handleRequest(Engine &engine, const std::string &request, std::string &response);
+
+    /**
+     * Stops accepting clients and disconnects the connected ones.
+     */
+    void stop();
+
+private:
+    std::shared_ptr<Workspace> workspace;
+    std::shared_ptr<Saver> saver;
+    std::string socketPath;
+    std::string initialFile;
+    int listenSocket = -1;
+    // set once the socket file is ours to remove
+    bool bound = false;
+    std::atomic<bool> running{false};
+    std::mutex clientsMutex;
+    std::set<int> clients;
+    size_t activeClients = 0;
+    std::condition_variable clientsDone;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "Stats.h"
+
+#include <atomic>
+
+namespace
+{
+    std::atomic<uint64_t> bytesScanned{0};
+    std::atomic<uint64_t> tokensProduced{0};
+    std::atomic<uint64_t> nodesAllocated{0};
+    std::atomic<uint64_t> bytesAllocated{0};
+    std::atomic<uint64_t> nodesVisited{0};
+    std::atomic<uint64_t> bytesWritten{0};
+
+    std::atomic<uint64_t> phaseCalls[static_cast<size_t>(Phase::COUNT)];
+    std::atomic<uint64_t> phaseNanoseconds[static_cast<size_t>(Phase::COUNT)];
+
+    void add(std::atomic<uint64_t> &counter, uint64_t &amount)
+    {
+        if (amount != 0)
+        {
+            counter.fetch_add(amount, std::memory_order_relaxed);
+            amount = 0;
+        }
+    }
+}
+
+bool Stats::enabled()
+{
+    return JSON_PARSER_STATS != 0;
+}
+
+void Stats::publish(StatCounters &counters)
+{
+    add(bytesScanned, counters.bytesScanned);
+    add(tokensProduced, counters.tokensProduced);
+    add(nodesAllocated, counters.nodesAllocated);
+    add(bytesAllocated, counters.bytesAllocated);
+    add(nodesVisited, counters.nodesVisited);
+    add(bytesWritten, counters.bytesWritten);
+}
+
+void Stats::recordPhase(Phase phase, uint64_t nanoseconds)
+{
+    size_t index = static_cast<size_t>(phase);
+    phaseCalls[index].fetch_add(1, std::memory_order_relaxed);
+    phaseNanoseconds[index].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void Stats::reset()
+{
+    bytesScanned = 0;
+    tokensProduced = 0;
+    nodesAllocated = 0;
+    bytesAllocated = 0;
+    nodesVisited = 0;
+    bytesWritten = 0;
+
+    for (size_t i = 0; i < static_cast<size_t>(Phase::COUNT); i++)
+    {
+        phaseCalls[i] = 0;
+        phaseNanoseconds[i] = 0;
+    }
+}
+
+void Stats::print(std::ostream &out)
+{
+    if (!enabled())
+    {
+        out << "Statistics are disabled in this build (JSON_PARSER_STATS=0)." << std::endl;
+        return;
+    }
+
+    out << "bytes scanned:   " << bytesScanned.load() << std::endl;
+    out << "tokens produced: " << tokensProduced.load() << std::endl;
+    out << "nodes allocated: " << nodesAllocated.load() << std::endl;
+    out << "bytes allocated: " << bytesAllocated.load() << std::endl;
+    out << "nodes visited:   " << nodesVisited.load() << std::endl;
+    out << "bytes written:   " << bytesWritten.load() << std::endl;
+
+    for (size_t i = 0; i < static_cast<size_t>(Phase::COUNT); i++)
+    {
+        out << phaseName(static_cast<Phase>(i)) << ": " << phaseCalls[i].load() << " calls, "
+            << phaseNanoseconds[i].load() / 1000000.0 << " ms" << std::endl;
+    }
+}
+
+void Stats::writeJSON(std::ostream &out)
+{
+    out << "{\"enabled\": " << (enabled() ? "true" : "false")
+        << ", \"bytesScanned\": " << bytesScanned.load()
+        << ", \"tokensProduced\": " << tokensProduced.load()
+        << ", \"nodesAllocated\": " << nodesAllocated.load()
+        << ", \"bytesAllocated\": " << bytesAllocated.load()
+        << ", \"nodesVisited\": " << nodesVisited.load()
+        << ", \"bytesWritten\": " << bytesWritten.load()
+        << ", \"phases\": {";
+
+    for (size_t i = 0; i < static_cast<size_t>(Phase::COUNT); i++)
+    {
+        if (i > 0)
+        {
+            out << ", ";
+        }
+        out << "\"" << phaseName(static_cast<Phase>(i)) << "\": {\"calls\": " << phaseCalls[i].load()
+            << ", \"nanoseconds\": " << phaseNanoseconds[i].load() << "}";
+    }
+
+    out << "}}" << std::endl;
+}
+
+const char *Stats::phaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::READ:
+        return "read";
+    case Phase::PARSE:
+        return "parse";
+    case Phase::VALIDATE:
+        return "validate";
+    case Phase::SEARCH:
+        return "search";
+    case Phase::MUTATE:
+        return "mutate";
+    case Phase::SERIALIZE:
+        return "serialize";
+    case Phase::COUNT:
+        break;
+    }
+
+    return "unknown";
+}
+
+PhaseTimer::PhaseTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+
+PhaseTimer::~PhaseTimer()
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    Stats::recordPhase(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
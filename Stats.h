@@ -0,0 +1,119 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+/**
+ * Enables the runtime counters. When it is 0 every JSON_STATS_* macro expands
+ * to nothing, so the counters cost nothing.
+ */
+#ifndef JSON_PARSER_STATS
+#define JSON_PARSER_STATS 0
+#endif
+
+/**
+ * Enum representing a phase of work whose time is measured.
+ */
+enum class Phase
+{
+    READ,
+    PARSE,
+    VALIDATE,
+    SEARCH,
+    MUTATE,
+    SERIALIZE,
+    COUNT
+};
+
+/**
+ * Plain counters accumulated locally by a component and published to the
+ * global statistics in one step, so hot loops never touch shared memory.
+ */
+struct StatCounters
+{
+    uint64_t bytesScanned = 0;
+    uint64_t tokensProduced = 0;
+    uint64_t nodesAllocated = 0;
+    uint64_t bytesAllocated = 0;
+    uint64_t nodesVisited = 0;
+    uint64_t bytesWritten = 0;
+};
+
+/**
+ * Process-wide statistics collected by the lexer, parser, validator, searcher and serializers.
+ */
+class Stats
+{
+public:
+    /**
+     * Returns true if the counters were compiled in.
+     */
+    static bool enabled();
+
+    /**
+     * Adds locally accumulated counters to the global ones and clears them.
+     *
+     * @param counters the counters to publish
+     */
+    static void publish(StatCounters &counters);
+
+    /**
+     * Records time spent in a phase.
+     *
+     * @param phase the phase the time was spent in
+     * @param nanoseconds the elapsed time
+     */
+    static void recordPhase(Phase phase, uint64_t nanoseconds);
+
+    /**
+     * Clears all counters and phase timings.
+     */
+    static void reset();
+
+    /**
+     * Prints the statistics in a human-readable table.
+     *
+     * @param out the stream to print to
+     */
+    static void print(std::ostream &out);
+
+    /**
+     * Writes the statistics as a single line of JSON.
+     *
+     * @param out the stream to write to
+     */
+    static void writeJSON(std::ostream &out);
+
+    /**
+     * Returns the name of a phase.
+     */
+    static const char *phaseName(Phase phase);
+};
+
+/**
+ * Measures the time between its construction and destruction and records it for a phase.
+ */
+class PhaseTimer
+{
+public:
+    PhaseTimer(Phase phase);
+    ~PhaseTimer();
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#if JSON_PARSER_STATS
+#define JSON_STATS_ADD(counters, field, amount) ((counters).field += (amount))
+#define JSON_STATS_PUBLISH(counters) Stats::publish(counters)
+#define JSON_STATS_PHASE(phase) PhaseTimer phaseTimer(phase)
+#else
+#define JSON_STATS_ADD(counters, field, amount) ((void)0)
+#define JSON_STATS_PUBLISH(counters) ((void)0)
+#define JSON_STATS_PHASE(phase) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#include "StreamValidator.h"
+
+#include <cerrno>
+#include <stdexcept>
+#include <vector>
+
+#include <unistd.h>
+
+StreamValidator::StreamValidator() : parser(sink)
+{
+}
+
+void StreamValidator::feed(const char *data, size_t size)
+{
+    if (!detected)
+    {
+        head.append(data, size);
+        if (head.size() < 4 && size > 0)
+        {
+            return;
+        }
+        detected = true;
+        CompressionFormat format = Compression::detect(head.data(), head.size());
+        if (format != CompressionFormat::NONE)
+        {
+            decompressor.reset(new Decompressor(format));
+        }
+        data = head.data();
+        size = head.size();
+    }
+
+    if (decompressor)
+    {
+        decompressed.clear();
+        decompressor->feed(data, size, decompressed);
+        parser.feed(decompressed);
+    }
+    else
+    {
+        parser.feed(data, size);
+    }
+}
+
+void StreamValidator::finish()
+{
+    if (!detected)
+    {
+        feed("", 0);
+    }
+    if (decompressor)
+    {
+        decompressor->finish();
+    }
+    parser.finish();
+}
+
+void StreamValidator::validate(int fd)
+{
+    StreamValidator validator;
+    std::vector<char> buffer(READ_SIZE);
+    while (true)
+    {
+        ssize_t count = ::read(fd, buffer.data(), buffer.size());
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count < 0)
+        {
+            throw std::runtime_error("Could not read the input");
+        }
+        if (count == 0)
+        {
+            break;
+        }
+        validator.feed(buffer.data(), static_cast<size_t>(count));
+    }
+    validator.finish();
+}
@@ -0,0 +1,65 @@
+#ifndef STREAM_VALIDATOR_H
+#define STREAM_VALIDATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "Compression.h"
+#include "PushParser.h"
+#include "ValidateSink.h"
+
+/**
+ * Validates JSON read from a pipe as it arrives, without waiting for the
+ * end. Input that is gzip or zstd compressed, which is recognised by its
+ * magic bytes, is decompressed on the way.
+ */
+class StreamValidator
+{
+public:
+    /**
+     * Size of the blocks read from the file descriptor.
+     */
+    static const size_t READ_SIZE = 64 * 1024;
+
+    StreamValidator();
+
+    /**
+     * Validates the next bytes of the input.
+     *
+     * @param data the bytes, compressed or not
+     * @param size number of bytes
+     *
+     * @throws {std::runtime_error} if the input is not valid JSON, its data is corrupt or its compression is not supported by this build
+     */
+    void feed(const char *data, size_t size);
+
+    /**
+     * Checks that the input ended where a JSON value ends.
+     *
+     * @throws {std::runtime_error} if the input is truncated or not valid JSON
+     */
+    void finish();
+
+    /**
+     * Reads a file descriptor to its end and validates what it reads.
+     *
+     * @param fd the file descriptor to read, such as standard input
+     *
+     * @throws {std::runtime_error} if it cannot be read or the input is not valid JSON
+     */
+    static void validate(int fd);
+
+private:
+    ValidateSink sink;
+    PushParser<ValidateSink> parser;
+
+    // The first bytes are held back until there are enough of them to
+    // recognise compressed input.
+    std::string head;
+    bool detected = false;
+    std::unique_ptr<Decompressor> decompressor;
+    std::string decompressed;
+};
+
+#endif
@@ -0,0 +1,295 @@
+#include "StringCodec.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+size_t StringCodec::findSpecial(const char *data, size_t size)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        // max(x, 0x1F) == 0x1F exactly when x <= 0x1F as an unsigned byte.
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                       _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        int mask = _mm_movemask_epi8(special);
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+
+    for (; i < size; i++)
+    {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c == '"' || c == '\\' || c < 0x20)
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+size_t StringCodec::validateUtf8(const char *data, size_t size)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    size_t i = 0;
+
+    while (i < size)
+    {
+#if defined(__SSE2__)
+        // Skip runs of ASCII, which is what most strings consist of, 16 bytes at a time.
+        while (i + 16 <= size && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i))) == 0)
+        {
+            i += 16;
+        }
+        if (i >= size)
+        {
+            break;
+        }
+#endif
+
+        unsigned char lead = bytes[i];
+        if (lead < 0x80)
+        {
+            i++;
+            continue;
+        }
+
+        size_t length;
+        unsigned char min = 0x80;
+        unsigned char max = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF)
+        {
+            length = 2;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            length = 3;
+            min = lead == 0xE0 ? 0xA0 : 0x80; // no overlong forms
+            max = lead == 0xED ? 0x9F : 0xBF; // no surrogates
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            length = 4;
+            min = lead == 0xF0 ? 0x90 : 0x80; // no overlong forms
+            max = lead == 0xF4 ? 0x8F : 0xBF; // nothing above U+10FFFF
+        }
+        else
+        {
+            return i;
+        }
+
+        if (i + length > size || bytes[i + 1] < min || bytes[i + 1] > max)
+        {
+            return i;
+        }
+        for (size_t k = 2; k < length; k++)
+        {
+            if ((bytes[i + k] & 0xC0) != 0x80)
+            {
+                return i;
+            }
+        }
+        i += length;
+    }
+
+    return size;
+}
+
+void StringCodec::unescape(const char *data, size_t size, std::string &out)
+{
+    out.clear();
+    out.reserve(size);
+
+    auto hexValue = [&](size_t at) -> unsigned
+    {
+        if (at + 4 > size)
+        {
+            throw std::runtime_error("Incomplete \\u escape");
+        }
+
+        unsigned value = 0;
+        for (size_t k = at; k < at + 4; k++)
+        {
+            char c = data[k];
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+                value |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                value |= c - 'A' + 10;
+            else
+                throw std::runtime_error("Invalid hex digit in \\u escape");
+        }
+        return value;
+    };
+
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t run = findSpecial(data + i, size - i);
+        out.append(data + i, run);
+        i += run;
+        if (i == size)
+        {
+            break;
+        }
+        if (data[i] != '\\')
+        {
+            out += data[i++];
+            continue;
+        }
+
+        if (i + 1 >= size)
+        {
+            throw std::runtime_error("Incomplete escape sequence");
+        }
+
+        char c = data[i + 1];
+        i += 2;
+        switch (c)
+        {
+        case '"':
+            out += '"';
+            break;
+        case '\\':
+            out += '\\';
+            break;
+        case '/':
+            out += '/';
+            break;
+        case 'b':
+            out += '\b';
+            break;
+        case 'f':
+            out += '\f';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 't':
+            out += '\t';
+            break;
+        case 'u':
+        {
+            unsigned codePoint = hexValue(i);
+            i += 4;
+            if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+            {
+                throw std::runtime_error("Unpaired low surrogate in \\u escape");
+            }
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+            {
+                if (i + 2 > size || data[i] != '\\' || data[i + 1] != 'u')
+                {
+                    throw std::runtime_error("Unpaired high surrogate in \\u escape");
+                }
+                unsigned low = hexValue(i + 2);
+                if (low < 0xDC00 || low > 0xDFFF)
+                {
+                    throw std::runtime_error("Unpaired high surrogate in \\u escape");
+                }
+                i += 6;
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+
+            if (codePoint < 0x80)
+            {
+                out += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (codePoint >> 6));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (codePoint >> 12));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (codePoint >> 18));
+                out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            break;
+        }
+        default:
+            throw std::runtime_error(std::string("Invalid escape sequence '\\") + c + "'");
+        }
+    }
+}
+
+void StringCodec::writeQuoted(std::ostream &out, const std::string &value)
+{
+    // Escaping into a reused buffer and writing it in one call is cheaper
+    // than several small writes, each of which checks the stream's state.
+    static thread_local std::string buffer;
+    buffer.clear();
+    appendQuoted(buffer, value);
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+void StringCodec::appendQuoted(std::string &out, const std::string &value)
+{
+    char buffer[8];
+    const char *data = value.data();
+    size_t size = value.size();
+
+    out += '"';
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t run = findSpecial(data + i, size - i);
+        out.append(data + i, run);
+        i += run;
+        if (i < size)
+        {
+            out += escapeSequence(data[i], buffer);
+            i++;
+        }
+    }
+    out += '"';
+}
+
+const char *StringCodec::escapeSequence(char c, char *buffer)
+{
+    switch (c)
+    {
+    case '"':
+        return "\\\"";
+    case '\\':
+        return "\\\\";
+    case '\b':
+        return "\\b";
+    case '\f':
+        return "\\f";
+    case '\n':
+        return "\\n";
+    case '\r':
+        return "\\r";
+    case '\t':
+        return "\\t";
+    default:
+        std::snprintf(buffer, 8, "\\u%04x", static_cast<unsigned char>(c));
+        return buffer;
+    }
+}
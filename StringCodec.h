@@ -0,0 +1,79 @@
+#ifndef STRING_CODEC_H
+#define STRING_CODEC_H
+
+#include <iostream>
+#include <string>
+
+/**
+ * Scanning, validation, unescaping and escaping of JSON string contents.
+ * The scans look at 16 bytes at a time with SSE2 where it is available and
+ * fall back to one byte at a time elsewhere.
+ */
+class StringCodec
+{
+public:
+    /**
+     * Finds the first byte that ends a run of plain string content: a quote,
+     * a backslash or a control character.
+     *
+     * @param data the bytes to scan
+     * @param size number of bytes to scan
+     *
+     * @return offset of the first such byte, or size if there is none
+     */
+    static size_t findSpecial(const char *data, size_t size);
+
+    /**
+     * Checks that bytes are well-formed UTF-8: no overlong forms, surrogates
+     * or code points above U+10FFFF.
+     *
+     * @param data the bytes to check
+     * @param size number of bytes to check
+     *
+     * @return offset of the first invalid byte, or size if all are valid
+     */
+    static size_t validateUtf8(const char *data, size_t size);
+
+    /**
+     * Decodes the escape sequences of a string's contents, including
+     * \uXXXX escapes and surrogate pairs, which are written as UTF-8.
+     *
+     * @param data the string contents without the surrounding quotes
+     * @param size number of bytes of content
+     * @param out receives the decoded string
+     *
+     * @throws {std::runtime_error} if an escape sequence is invalid
+     */
+    static void unescape(const char *data, size_t size, std::string &out);
+
+    /**
+     * Writes a string as a quoted JSON string, escaping quotes, backslashes
+     * and control characters.
+     *
+     * @param out the stream to write to
+     * @param value the string to write
+     */
+    static void writeQuoted(std::ostream &out, const std::string &value);
+
+    /**
+     * Appends a string as a quoted JSON string, escaping quotes, backslashes
+     * and control characters.
+     *
+     * @param out the string to append to
+     * @param value the string to append
+     */
+    static void appendQuoted(std::string &out, const std::string &value);
+
+private:
+    /**
+     * Returns the escape sequence for a byte that findSpecial stops at.
+     *
+     * @param c the byte to escape
+     * @param buffer storage for \u00XX sequences, at least 7 bytes
+     *
+     * @return the escape sequence
+     */
+    static const char *escapeSequence(char c, char *buffer);
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of worker threads running submitted tasks in submission order.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * Starts the worker threads.
+     *
+     * @param threads number of workers, 0 for one per hardware thread
+     */
+    ThreadPool(size_t threads = 0);
+
+    /**
+     * Finishes all submitted tasks and stops the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Queues a task. Tasks must not throw.
+     *
+     * @param task the task to run on a worker
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * Waits until every submitted task has finished.
+     */
+    void wait();
+
+    /**
+     * Returns the number of worker threads.
+     */
+    size_t size() const;
+
+private:
+    /**
+     * Body of a worker thread.
+     */
+    void run();
+
+private:
+    std::deque<std::function<void()>> tasks;
+    size_t running = 0;
+    bool stopping = false;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<std::thread> workers;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef VALIDATE_SINK_H
+#define VALIDATE_SINK_H
+
+#include <cstddef>
+#include <string_view>
+
+/**
+ * Sink for BasicParser that ignores every event, so parsing only checks
+ * that the input is valid JSON. Its members are empty and inline, so a
+ * validating parser compiles to the bare scanning loop.
+ */
+class ValidateSink
+{
+public:
+    void startObject(size_t) {}
+    void endObject(size_t) {}
+    void startArray(size_t) {}
+    void endArray(size_t) {}
+    void key(std::string_view) {}
+    void string(std::string_view) {}
+    void number(std::string_view) {}
+    void boolean(bool) {}
+    void null() {}
+};
+
+#endif
@@ -1,130 +1,52 @@
 #include "Validator.h"
 
-Validator::Validator(Lexer &lexer) : lexer(lexer), currentToken(lexer.nextToken()) {}
+Validator::Validator(Lexer &lexer, size_t maxDepth) : lexer(lexer), maxDepth(maxDepth) {}
+
+Validator::Validator(Lexer &&lexer, size_t maxDepth) : lexer(std::move(lexer)), maxDepth(maxDepth) {}
 
 bool Validator::validate()
 {
-    try
+    std::string error;
+    if (!validate(error))
     {
-        lexer.resetPos();
-        currentToken = lexer.nextToken();
-        validateValue();
-        if (currentToken.type != TokenType::END)
-        {
-            throw std::runtime_error("Unexpected characters at the end of JSON input.");
-        }
-        return true;
-    }
-    catch (const std::exception &e)
-    {
-        std::cerr << "Validation error: " << e.what() << std::endl;
+        std::cerr << "Validation error: " << error << std::endl;
         return false;
     }
+    return true;
 }
 
-void Validator::validateValue()
+bool Validator::validate(std::string &error)
 {
-    switch (currentToken.type)
-    {
-    case TokenType::LEFT_BRACE:
-        validateObject();
-        break;
-    case TokenType::LEFT_BRACKET:
-        validateArray();
-        break;
-    case TokenType::STRING:
-        validateString();
-        break;
-    case TokenType::NUMBER:
-        validateNumber();
-        break;
-    case TokenType::TRUE:
-    case TokenType::FALSE:
-    case TokenType::NULL_TYPE:
-        currentToken = lexer.nextToken();
-        break;
-    default:
-        throw std::runtime_error("Unexpected token at line " + std::to_string(lexer.getLine()) + ", column " + std::to_string(lexer.getColumn()));
-    }
-}
+    JSON_STATS_PHASE(Phase::VALIDATE);
 
-void Validator::validateObject()
-{
-    currentToken = lexer.nextToken();
-    if (currentToken.type != TokenType::RIGHT_BRACE)
+    try
     {
-        while (true)
-        {
-            if (currentToken.type != TokenType::STRING)
-            {
-                throwError("Expected string");
-            }
-            validateString();
-            if (currentToken.type != TokenType::COLON)
-            {
-                throwError("Expected ':'");
-            }
-            currentToken = lexer.nextToken();
-            validateValue();
-            if (currentToken.type == TokenType::COMMA)
-            {
-                currentToken = lexer.nextToken();
-            }
-            else
-            {
-                break;
-            }
-        }
-        if (currentToken.type != TokenType::RIGHT_BRACE)
-            throwError("Expected '}'");
+        ValidateSink sink;
+        BasicParser<ValidateSink> parser(lexer.getInput(), maxDepth);
+        parser.parse(sink);
+        return true;
     }
-    currentToken = lexer.nextToken();
-}
-
-void Validator::validateArray()
-{
-    currentToken = lexer.nextToken();
-    if (currentToken.type != TokenType::RIGHT_BRACKET)
+    catch (const std::exception &e)
     {
-        while (true)
-        {
-            validateValue();
-            if (currentToken.type == TokenType::COMMA)
-            {
-                currentToken = lexer.nextToken();
-            }
-            else
-            {
-                break;
-            }
-        }
-        if (currentToken.type != TokenType::RIGHT_BRACKET)
-        {
-            throwError("Expected ']'");
-        }
+        error = e.what();
+        return false;
     }
-    currentToken = lexer.nextToken();
 }
 
-void Validator::validateString()
+bool Validator::validate(const Schema &schema, std::string &error)
 {
-    if (currentToken.type != TokenType::STRING)
+    JSON_STATS_PHASE(Phase::VALIDATE);
+
+    try
     {
-        throwError("Expected string");
+        SchemaSink sink(schema);
+        BasicParser<SchemaSink> parser(lexer.getInput(), maxDepth);
+        parser.parse(sink);
+        return true;
     }
-    currentToken = lexer.nextToken();
-}
-
-void Validator::validateNumber()
-{
-    if (currentToken.type != TokenType::NUMBER)
+    catch (const std::exception &e)
     {
-        throwError("Expected number");
+        error = e.what();
+        return false;
     }
-    currentToken = lexer.nextToken();
-}
-
-void Validator::throwError(const std::string &message)
-{
-    throw std::runtime_error(message + " at line " + std::to_string(lexer.getLine()) + ", column " + std::to_string(lexer.getColumn()));
 }
@@ -1,72 +1,64 @@
 #ifndef VALIDATOR_H
 #define VALIDATOR_H
 
-#include "Lexer.h"
+#include "BasicParser.h"
+#include "SchemaSink.h"
+#include "ValidateSink.h"
 
 /**
- * Class used for validating JSON.
+ * Class used for validating JSON. The input is checked by a BasicParser that
+ * builds nothing and tracks no positions, which are recovered only for an error.
  */
 class Validator
 {
 public:
     /**
      * Constructor of a validator object with a given Lexer object.
-     */
-    Validator(Lexer &lexer);
-
-    /**
-     * Validates the JSON string provided in the Lexer object.
      *
-     * @return true if the JSON string is a valid JSON format
+     * @param lexer the Lexer holding the JSON input
+     * @param maxDepth maximum nesting depth of objects and arrays
      */
-    bool validate();
+    Validator(Lexer &lexer, size_t maxDepth = DEFAULT_MAX_DEPTH);
 
-private:
     /**
-     * Validates a JSON value.
+     * Constructor of a validator object that takes over a Lexer object,
+     * avoiding a copy of its input.
      *
-     * @throws {std::runtime_error} if there is incorrect JSON in the value
+     * @param lexer the Lexer holding the JSON input
+     * @param maxDepth maximum nesting depth of objects and arrays
      */
-    void validateValue();
+    Validator(Lexer &&lexer, size_t maxDepth = DEFAULT_MAX_DEPTH);
 
     /**
-     * Validates a JSON object.
+     * Validates the JSON string provided in the Lexer object.
      *
-     * @throws {std::runtime_error} if there is incorrect JSON
+     * @return true if the JSON string is a valid JSON format
      */
-    void validateObject();
+    bool validate();
 
     /**
-     * Validates a JSON array.
+     * Validates the JSON string provided in the Lexer object without printing anything.
      *
-     * @throws {std::runtime_error} if there is incorrect JSON
-     */
-    void validateArray();
-
-    /**
-     * Validates a JSON string.
-     * 
-     * @throws {std::runtime_error} if there is incorrect JSON
-     */
-    void validateString();
-
-    /**
-     * Validates a JSON value.
-     * 
-     * @throws {std::runtime_error} if there is incorrect JSON
+     * @param error receives the reason if the JSON is not valid
+     *
+     * @return true if the JSON string is a valid JSON format
      */
-    void validateNumber();
+    bool validate(std::string &error);
 
     /**
-     * Throws a std::runtime_error with a message.
-     * 
-     * @param message message to display in the error
+     * Validates the JSON string provided in the Lexer object and checks it
+     * against a JSON Schema, both in one pass over the input.
+     *
+     * @param schema the compiled schema
+     * @param error receives the reason if the JSON is not valid or does not conform
+     *
+     * @return true if the JSON string is valid and conforms to the schema
      */
-    void throwError(const std::string &message);
+    bool validate(const Schema &schema, std::string &error);
 
 private:
     Lexer lexer;
-    Token currentToken;
+    size_t maxDepth;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "Workspace.h"
+
+#include <filesystem>
+#include <iomanip>
+
+#include <sys/stat.h>
+
+Workspace::Workspace(size_t memoryBudget) : memoryBudget(memoryBudget) {}
+
+std::shared_ptr<Parser> Workspace::open(const std::string &givenPath, size_t maxDepth, OpenResult &result)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string path = canonicalPath(givenPath);
+    int64_t modifiedNs;
+    int64_t fileSize;
+    if (!fileVersion(path, modifiedNs, fileSize))
+    {
+        throw std::runtime_error("Could not read file " + givenPath);
+    }
+
+    auto found = index.find(path);
+    if (found != index.end())
+    {
+        WorkspaceEntry &entry = *found->second;
+        if (entry.maxDepth == maxDepth)
+        {
+            entries.splice(entries.begin(), entries, found->second);
+            result = OpenResult::CACHED;
+            if (entry.modifiedNs != modifiedNs || entry.fileSize != fileSize)
+            {
+                entry.parser->reload(readFile(path));
+                entry.modifiedNs = modifiedNs;
+                entry.fileSize = fileSize;
+                memoryUsed -= entry.memoryBytes;
+                entry.memoryBytes = entry.parser->measureMemory().total();
+                memoryUsed += entry.memoryBytes;
+                enforceBudget();
+                result = OpenResult::RELOADED;
+            }
+            return entry.parser;
+        }
+        evict(found->second);
+    }
+
+    WorkspaceEntry entry;
+    entry.path = path;
+    {
+        ChunkReader reader(path);
+        entry.parser = std::make_shared<Parser>(reader, maxDepth);
+    }
+    entry.modifiedNs = modifiedNs;
+    entry.fileSize = fileSize;
+    entry.maxDepth = maxDepth;
+    entry.memoryBytes = entry.parser->measureMemory().total();
+
+    entries.push_front(std::move(entry));
+    index[path] = entries.begin();
+    memoryUsed += entries.front().memoryBytes;
+    enforceBudget();
+
+    result = OpenResult::PARSED;
+    return entries.front().parser;
+}
+
+bool Workspace::isStale(const std::string &givenPath) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string path = canonicalPath(givenPath);
+    auto found = index.find(path);
+    int64_t modifiedNs;
+    int64_t fileSize;
+    if (found == index.end() || !fileVersion(path, modifiedNs, fileSize))
+    {
+        return false;
+    }
+
+    return found->second->modifiedNs != modifiedNs || found->second->fileSize != fileSize;
+}
+
+void Workspace::refresh(const std::string &givenPath, const Parser *parser, bool wholeDocument)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string path = canonicalPath(givenPath);
+    auto found = index.find(path);
+    if (found == index.end())
+    {
+        return;
+    }
+
+    WorkspaceEntry &entry = *found->second;
+    if (entry.parser.get() != parser || !wholeDocument || !fileVersion(path, entry.modifiedNs, entry.fileSize))
+    {
+        evict(found->second);
+        return;
+    }
+
+    memoryUsed -= entry.memoryBytes;
+    entry.memoryBytes = entry.parser->measureMemory().total();
+    memoryUsed += entry.memoryBytes;
+    enforceBudget();
+}
+
+void Workspace::setMemoryBudget(size_t memoryBudget)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->memoryBudget = memoryBudget;
+    enforceBudget();
+}
+
+size_t Workspace::getMemoryBudget() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return memoryBudget;
+}
+
+size_t Workspace::getMemoryUsed() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return memoryUsed;
+}
+
+void Workspace::print(std::ostream &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    const double MB = 1024.0 * 1024.0;
+    out << std::fixed << std::setprecision(2);
+    out << "Documents: " << entries.size() << ", memory: " << memoryUsed / MB << " MB of "
+        << memoryBudget / MB << " MB" << std::endl;
+    for (const WorkspaceEntry &entry : entries)
+    {
+        out << "  " << std::setw(10) << entry.memoryBytes / MB << " MB  " << entry.path << std::endl;
+    }
+    out << std::defaultfloat << std::setprecision(6);
+}
+
+std::string Workspace::readFile(const std::string &path)
+{
+    JSON_STATS_PHASE(Phase::READ);
+    return ChunkReader::readAll(path);
+}
+
+std::string Workspace::canonicalPath(const std::string &path)
+{
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    return error ? path : canonical.string();
+}
+
+bool Workspace::fileVersion(const std::string &path, int64_t &modifiedNs, int64_t &fileSize)
+{
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0)
+    {
+        return false;
+    }
+
+    modifiedNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    fileSize = static_cast<int64_t>(info.st_size);
+    return true;
+}
+
+void Workspace::enforceBudget()
+{
+    while (memoryUsed > memoryBudget && entries.size() > 1)
+    {
+        evict(std::prev(entries.end()));
+    }
+}
+
+void Workspace::evict(std::list<WorkspaceEntry>::iterator entry)
+{
+    memoryUsed -= entry->memoryBytes;
+    index.erase(entry->path);
+    entries.erase(entry);
+}
@@ -0,0 +1,162 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "Parser.h"
+
+/**
+ * Enum describing how Workspace::open obtained a document.
+ */
+enum class OpenResult
+{
+    PARSED,
+    CACHED,
+    RELOADED
+};
+
+/**
+ * A parsed document kept by the workspace, together with what identifies
+ * the version of the file it was parsed from.
+ */
+struct WorkspaceEntry
+{
+    // canonical path of the file
+    std::string path;
+    std::shared_ptr<Parser> parser;
+    int64_t modifiedNs = 0;
+    int64_t fileSize = 0;
+    size_t maxDepth = 0;
+    size_t memoryBytes = 0;
+};
+
+/**
+ * Keeps several parsed documents keyed by canonical path, so that switching
+ * back to a recently used file does not parse it again, however its path is
+ * spelled. A cached document is reused as is while the file's modification
+ * time and size are unchanged; when they change, only the changed part of
+ * the file is parsed again where possible.
+ *
+ * Documents are kept in least recently used order. Whenever the measured
+ * memory of all documents exceeds the budget, the least recently used ones
+ * are released, except for the one opened last.
+ *
+ * Several engines may share a workspace from their own threads; its
+ * methods are applied one at a time, so opening a file that is not cached
+ * holds up the others until it is parsed.
+ */
+class Workspace
+{
+public:
+    static const size_t DEFAULT_MEMORY_BUDGET = size_t(1) << 30;
+
+    /**
+     * Constructs an empty workspace.
+     *
+     * @param memoryBudget bytes the parsed documents may use together
+     */
+    Workspace(size_t memoryBudget = DEFAULT_MEMORY_BUDGET);
+
+    /**
+     * Returns the parsed document of a file, parsing it only if it is not
+     * cached or the file has changed since.
+     *
+     * @param path path to the JSON file
+     * @param maxDepth maximum nesting depth of objects and arrays
+     * @param result receives how the document was obtained
+     *
+     * @return the parsed document
+     * @throws {std::runtime_error} if the file cannot be read or is not valid JSON
+     */
+    std::shared_ptr<Parser> open(const std::string &path, size_t maxDepth, OpenResult &result);
+
+    /**
+     * Returns true if a document is cached and its file has changed since it was read.
+     *
+     * @param path path to the JSON file
+     */
+    bool isStale(const std::string &path) const;
+
+    /**
+     * Records that a document was written to a file. If it is the file's
+     * cached document and was written whole in the format it is read back
+     * in, the new version of the file is recognised as the cached one and
+     * the document is measured again. Anything else written over the file,
+     * such as another document or a part of one, no longer matches the
+     * cached document, which is released instead.
+     *
+     * @param path path to the JSON file
+     * @param parser the document that was written
+     * @param wholeDocument true if the whole document was written in the pretty format
+     */
+    void refresh(const std::string &path, const Parser *parser, bool wholeDocument);
+
+    /**
+     * Sets the memory budget and releases documents until it is met.
+     *
+     * @param memoryBudget bytes the parsed documents may use together
+     */
+    void setMemoryBudget(size_t memoryBudget);
+
+    /**
+     * Returns the memory budget in bytes.
+     */
+    size_t getMemoryBudget() const;
+
+    /**
+     * Returns the measured memory of all cached documents in bytes.
+     */
+    size_t getMemoryUsed() const;
+
+    /**
+     * Prints the cached documents and the memory they use.
+     *
+     * @param out the stream to print to
+     */
+    void print(std::ostream &out) const;
+
+    /**
+     * Returns the path the workspace knows a file by: absolute, with "." and
+     * ".." steps and symbolic links resolved.
+     *
+     * @param path path to the file as given
+     */
+    static std::string canonicalPath(const std::string &path);
+
+private:
+    /**
+     * Reads a whole file, decompressing it if it is compressed.
+     *
+     * @throws {std::runtime_error} if the file cannot be read
+     */
+    static std::string readFile(const std::string &path);
+
+    /**
+     * Reads the modification time and size of a file.
+     *
+     * @return false if the file does not exist
+     */
+    static bool fileVersion(const std::string &path, int64_t &modifiedNs, int64_t &fileSize);
+
+    /**
+     * Releases least recently used documents until the budget is met.
+     * The most recently used document is always kept.
+     */
+    void enforceBudget();
+
+    /**
+     * Removes an entry and releases its document.
+     */
+    void evict(std::list<WorkspaceEntry>::iterator entry);
+
+private:
+    std::list<WorkspaceEntry> entries;
+    std::unordered_map<std::string, std::list<WorkspaceEntry>::iterator> index;
+    size_t memoryBudget;
+    size_t memoryUsed = 0;
+    mutable std::mutex mutex;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include "Allocations.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <sys/resource.h>
+
+namespace
+{
+    /**
+     * Allocation counts of one thread, on a cache line of its own, so that
+     * threads allocating at the same time do not contend for the counters.
+     */
+    struct alignas(64) ThreadCounters
+    {
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> bytes{0};
+    };
+
+    // Threads beyond the last slot share it.
+    const size_t MAX_THREADS = 256;
+    ThreadCounters slots[MAX_THREADS];
+    std::atomic<size_t> slotsUsed{0};
+
+    // Taking a slot allocates nothing, as operator new itself lands here.
+    thread_local ThreadCounters *threadCounters = nullptr;
+
+    void *countedAllocate(size_t size)
+    {
+        if (!threadCounters)
+        {
+            threadCounters = &slots[std::min(slotsUsed.fetch_add(1, std::memory_order_relaxed), MAX_THREADS - 1)];
+        }
+        threadCounters->allocations.fetch_add(1, std::memory_order_relaxed);
+        threadCounters->bytes.fetch_add(size, std::memory_order_relaxed);
+
+        void *memory = std::malloc(size == 0 ? 1 : size);
+        if (!memory)
+        {
+            throw std::bad_alloc();
+        }
+        return memory;
+    }
+}
+
+void *operator new(size_t size)
+{
+    return countedAllocate(size);
+}
+
+void *operator new[](size_t size)
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+AllocationCounters Allocations::current()
+{
+    AllocationCounters counters;
+    size_t used = std::min(slotsUsed.load(std::memory_order_relaxed), MAX_THREADS);
+    for (size_t i = 0; i < used; i++)
+    {
+        counters.allocations += slots[i].allocations.load(std::memory_order_relaxed);
+        counters.bytes += slots[i].bytes.load(std::memory_order_relaxed);
+    }
+    return counters;
+}
+
+size_t Allocations::peakRssKb()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+    return static_cast<size_t>(usage.ru_maxrss);
+}
@@ -0,0 +1,32 @@
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include <cstddef>
+
+/**
+ * Snapshot of the global allocation counters maintained by the benchmark binary.
+ */
+struct AllocationCounters
+{
+    size_t allocations = 0;
+    size_t bytes = 0;
+};
+
+/**
+ * Gives access to the counters of the replaced global operator new.
+ */
+class Allocations
+{
+public:
+    /**
+     * Returns the number of allocations and allocated bytes since the process started.
+     */
+    static AllocationCounters current();
+
+    /**
+     * Returns the peak resident set size of the process in kilobytes.
+     */
+    static size_t peakRssKb();
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "Benchmark.h"
+#include "Allocations.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+namespace
+{
+    double percentile(const std::vector<double> &sorted, double fraction)
+    {
+        size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+}
+
+Benchmark::Benchmark(const BenchmarkOptions &options, std::ostream &out) : options(options), out(out) {}
+
+BenchmarkResult Benchmark::run(const std::string &name, const std::string &corpus, size_t inputBytes,
+                               const std::function<void()> &body, const std::function<void()> &setup)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<double> samples;
+    double totalNs = 0;
+    size_t allocations = 0;
+    size_t allocatedBytes = 0;
+
+    // The time budget includes untimed setup, so benchmarks with an expensive
+    // setup run fewer iterations instead of taking proportionally longer.
+    Clock::time_point began = Clock::now();
+    while (samples.size() < options.maxIterations &&
+           (samples.size() < options.minIterations ||
+            std::chrono::duration<double>(Clock::now() - began).count() < options.minSeconds))
+    {
+        if (setup)
+        {
+            setup();
+        }
+
+        AllocationCounters before = Allocations::current();
+        Clock::time_point start = Clock::now();
+        body();
+        Clock::time_point end = Clock::now();
+        AllocationCounters after = Allocations::current();
+
+        double elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+        samples.push_back(elapsed);
+        totalNs += elapsed;
+        allocations += after.allocations - before.allocations;
+        allocatedBytes += after.bytes - before.bytes;
+    }
+
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.corpus = corpus;
+    result.inputBytes = inputBytes;
+    result.iterations = samples.size();
+    result.meanNs = totalNs / samples.size();
+    result.p50Ns = percentile(sorted, 0.50);
+    result.p90Ns = percentile(sorted, 0.90);
+    result.p99Ns = percentile(sorted, 0.99);
+    result.maxNs = sorted.back();
+    result.throughputMbPerSecond = result.meanNs > 0 ? (inputBytes / 1e6) / (result.meanNs / 1e9) : 0;
+    result.allocationsPerOp = static_cast<double>(allocations) / samples.size();
+    result.allocatedBytesPerOp = static_cast<double>(allocatedBytes) / samples.size();
+    result.peakRssKb = Allocations::peakRssKb();
+
+    report(result);
+    return result;
+}
+
+bool Benchmark::selected(const std::string &name) const
+{
+    return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+void Benchmark::setFilter(const std::string &filter)
+{
+    this->filter = filter;
+}
+
+void Benchmark::report(const BenchmarkResult &result)
+{
+    out << "{\"benchmark\": \"" << result.name << "\""
+        << ", \"corpus\": \"" << result.corpus << "\""
+        << ", \"input_bytes\": " << result.inputBytes
+        << ", \"iterations\": " << result.iterations
+        << ", \"mean_ns\": " << static_cast<uint64_t>(result.meanNs)
+        << ", \"p50_ns\": " << static_cast<uint64_t>(result.p50Ns)
+        << ", \"p90_ns\": " << static_cast<uint64_t>(result.p90Ns)
+        << ", \"p99_ns\": " << static_cast<uint64_t>(result.p99Ns)
+        << ", \"max_ns\": " << static_cast<uint64_t>(result.maxNs)
+        << ", \"throughput_mb_s\": " << result.throughputMbPerSecond
+        << ", \"allocations_per_op\": " << result.allocationsPerOp
+        << ", \"allocated_bytes_per_op\": " << static_cast<uint64_t>(result.allocatedBytesPerOp)
+        << ", \"peak_rss_kb\": " << result.peakRssKb
+        << "}" << std::endl;
+}
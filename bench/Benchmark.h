@@ -0,0 +1,88 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <functional>
+#include <iostream>
+#include <string>
+
+/**
+ * Options controlling how many times a benchmark body is run.
+ */
+struct BenchmarkOptions
+{
+    size_t minIterations = 5;
+    size_t maxIterations = 1000;
+    double minSeconds = 0.5;
+};
+
+/**
+ * Measurements of a single benchmark over one corpus.
+ */
+struct BenchmarkResult
+{
+    std::string name;
+    std::string corpus;
+    size_t inputBytes = 0;
+    size_t iterations = 0;
+    double meanNs = 0;
+    double p50Ns = 0;
+    double p90Ns = 0;
+    double p99Ns = 0;
+    double maxNs = 0;
+    double throughputMbPerSecond = 0;
+    double allocationsPerOp = 0;
+    double allocatedBytesPerOp = 0;
+    size_t peakRssKb = 0;
+};
+
+/**
+ * Runs benchmark bodies and reports their results as JSON lines.
+ */
+class Benchmark
+{
+public:
+    /**
+     * Constructs a benchmark runner.
+     *
+     * @param options iteration limits applied to every benchmark
+     * @param out stream the JSON lines are written to
+     */
+    Benchmark(const BenchmarkOptions &options, std::ostream &out);
+
+    /**
+     * Runs a benchmark and reports its result.
+     *
+     * @param name name of the benchmarked operation
+     * @param corpus name of the corpus it runs on
+     * @param inputBytes size of the corpus, used for throughput
+     * @param body the timed operation
+     * @param setup untimed preparation run before every iteration (optional)
+     *
+     * @return the measured result
+     */
+    BenchmarkResult run(const std::string &name, const std::string &corpus, size_t inputBytes,
+                        const std::function<void()> &body, const std::function<void()> &setup = nullptr);
+
+    /**
+     * Returns true if a benchmark with the given name passes the name filter.
+     */
+    bool selected(const std::string &name) const;
+
+    /**
+     * Only benchmarks whose name contains the filter are run.
+     */
+    void setFilter(const std::string &filter);
+
+private:
+    /**
+     * Writes a result as a single line of JSON.
+     */
+    void report(const BenchmarkResult &result);
+
+private:
+    BenchmarkOptions options;
+    std::ostream &out;
+    std::string filter;
+};
+
+#endif
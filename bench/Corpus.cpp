@@ -0,0 +1,255 @@
+#include "Corpus.h"
+
+namespace
+{
+    // Deep documents are made of chains of this many nested containers.
+    const size_t CHAIN_DEPTH = 256;
+}
+
+std::string Corpus::generate(CorpusKind kind, size_t targetBytes)
+{
+    uint64_t state = 0x9E3779B97F4A7C15ULL ^ static_cast<uint64_t>(kind);
+    std::string out;
+    out.reserve(targetBytes + 1024);
+    out += "{\n  \"meta\": {\"id\": 1, \"name\": \"corpus\", \"version\": 3, \"owner\": \"bench\"},\n  \"data\": ";
+
+    switch (kind)
+    {
+    case CorpusKind::DEEP_NESTING:
+        deepNesting(out, targetBytes, state);
+        break;
+    case CorpusKind::WIDE_OBJECT:
+        wideObject(out, targetBytes, state);
+        break;
+    case CorpusKind::LARGE_ARRAY:
+        largeArray(out, targetBytes, state);
+        break;
+    case CorpusKind::STRING_HEAVY:
+        stringHeavy(out, targetBytes, state);
+        break;
+    case CorpusKind::NUMBER_HEAVY:
+        numberHeavy(out, targetBytes, state);
+        break;
+    }
+
+    out += "\n}\n";
+    return out;
+}
+
+std::string Corpus::name(CorpusKind kind)
+{
+    switch (kind)
+    {
+    case CorpusKind::DEEP_NESTING:
+        return "deep-nesting";
+    case CorpusKind::WIDE_OBJECT:
+        return "wide-object";
+    case CorpusKind::LARGE_ARRAY:
+        return "large-array";
+    case CorpusKind::STRING_HEAVY:
+        return "string-heavy";
+    case CorpusKind::NUMBER_HEAVY:
+        return "number-heavy";
+    }
+
+    return "unknown";
+}
+
+std::vector<CorpusKind> Corpus::allKinds()
+{
+    return {CorpusKind::DEEP_NESTING, CorpusKind::WIDE_OBJECT, CorpusKind::LARGE_ARRAY,
+            CorpusKind::STRING_HEAVY, CorpusKind::NUMBER_HEAVY};
+}
+
+std::string Corpus::searchKey()
+{
+    return "needle";
+}
+
+std::string Corpus::schema(CorpusKind kind)
+{
+    std::string data;
+    switch (kind)
+    {
+    case CorpusKind::DEEP_NESTING:
+        data = "{\"type\": \"array\", \"items\": {\"type\": \"object\", \"properties\": {\"level\": {\"type\": \"array\"}}}}";
+        break;
+    case CorpusKind::WIDE_OBJECT:
+        data = "{\"type\": \"object\", \"additionalProperties\": {\"type\": [\"integer\", \"string\", \"boolean\", \"null\", \"object\"],"
+               " \"properties\": {\"needle\": {\"type\": \"integer\"}}}}";
+        break;
+    case CorpusKind::LARGE_ARRAY:
+        data = "{\"type\": \"array\", \"items\": {\"type\": [\"integer\", \"object\"], \"properties\": {\"needle\": {\"type\": \"integer\"},"
+               " \"tags\": {\"type\": \"array\", \"items\": {\"type\": \"integer\"}}}, \"required\": [\"needle\", \"tags\"]}}";
+        break;
+    case CorpusKind::STRING_HEAVY:
+        data = "{\"type\": \"array\", \"items\": {\"type\": \"object\", \"properties\": {\"needle\": {\"type\": \"string\"},"
+               " \"text\": {\"type\": \"string\"}}, \"required\": [\"needle\", \"text\"], \"additionalProperties\": false}}";
+        break;
+    case CorpusKind::NUMBER_HEAVY:
+        data = "{\"type\": \"array\", \"items\": {\"type\": \"object\", \"properties\": {\"needle\": {\"type\": \"integer\"},"
+               " \"values\": {\"type\": \"array\", \"items\": {\"type\": \"number\"}}}, \"required\": [\"needle\", \"values\"]}}";
+        break;
+    }
+
+    return "{\"type\": \"object\", \"properties\": {\"meta\": {\"type\": \"object\", \"properties\": {\"id\": {\"type\": \"integer\"},"
+           " \"name\": {\"type\": \"string\"}, \"version\": {\"type\": \"integer\"}, \"owner\": {\"type\": \"string\"}},"
+           " \"required\": [\"id\", \"name\", \"version\", \"owner\"]}, \"data\": " +
+           data + "}, \"required\": [\"meta\", \"data\"]}";
+}
+
+void Corpus::deepNesting(std::string &out, size_t targetBytes, uint64_t &state)
+{
+    out += "[";
+    bool first = true;
+    while (first || out.size() < targetBytes)
+    {
+        if (!first)
+        {
+            out += ", ";
+        }
+        first = false;
+
+        for (size_t depth = 0; depth < CHAIN_DEPTH; depth++)
+        {
+            out += depth % 2 == 0 ? "{\"level\": " : "[";
+        }
+        out += "{\"needle\": " + std::to_string(next(state) % 1000) + "}";
+        for (size_t depth = CHAIN_DEPTH; depth > 0; depth--)
+        {
+            out += (depth - 1) % 2 == 0 ? "}" : "]";
+        }
+    }
+    out += "]";
+}
+
+void Corpus::wideObject(std::string &out, size_t targetBytes, uint64_t &state)
+{
+    out += "{";
+    size_t index = 0;
+    while (index == 0 || out.size() < targetBytes)
+    {
+        if (index > 0)
+        {
+            out += ",";
+        }
+        out += "\n    \"key" + std::to_string(index) + "\": ";
+        switch (next(state) % 4)
+        {
+        case 0:
+            out += std::to_string(next(state) % 100000);
+            break;
+        case 1:
+            out += "\"";
+            appendWord(out, 4 + next(state) % 12, state);
+            out += "\"";
+            break;
+        case 2:
+            out += next(state) % 2 == 0 ? "true" : "null";
+            break;
+        default:
+            out += "{\"needle\": " + std::to_string(index) + "}";
+            break;
+        }
+        index++;
+    }
+    out += "\n  }";
+}
+
+void Corpus::largeArray(std::string &out, size_t targetBytes, uint64_t &state)
+{
+    out += "[";
+    size_t index = 0;
+    while (index == 0 || out.size() < targetBytes)
+    {
+        if (index > 0)
+        {
+            out += ", ";
+        }
+        if (index % 8 == 0)
+        {
+            out += "{\"needle\": " + std::to_string(next(state) % 1000) + ", \"tags\": [1, 2, 3]}";
+        }
+        else
+        {
+            out += std::to_string(next(state) % 1000000);
+        }
+        index++;
+    }
+    out += "]";
+}
+
+void Corpus::stringHeavy(std::string &out, size_t targetBytes, uint64_t &state)
+{
+    out += "[";
+    size_t index = 0;
+    while (index == 0 || out.size() < targetBytes)
+    {
+        if (index > 0)
+        {
+            out += ",\n    ";
+        }
+        out += "{\"needle\": \"";
+        appendWord(out, 16 + next(state) % 48, state);
+        out += "\", \"text\": \"";
+        for (size_t words = 8 + next(state) % 24; words > 0; words--)
+        {
+            appendWord(out, 2 + next(state) % 10, state);
+            out += ' ';
+        }
+        appendWord(out, 5, state);
+        out += "\"}";
+        index++;
+    }
+    out += "]";
+}
+
+void Corpus::numberHeavy(std::string &out, size_t targetBytes, uint64_t &state)
+{
+    out += "[";
+    size_t index = 0;
+    while (index == 0 || out.size() < targetBytes)
+    {
+        if (index > 0)
+        {
+            out += ",\n    ";
+        }
+        out += "{\"needle\": " + std::to_string(index) + ", \"values\": [";
+        for (size_t i = 0; i < 16; i++)
+        {
+            if (i > 0)
+            {
+                out += ", ";
+            }
+            uint64_t random = next(state);
+            if (random % 3 == 0)
+            {
+                out += "-";
+            }
+            out += std::to_string(random % 1000000);
+            if (random % 2 == 0)
+            {
+                out += "." + std::to_string(next(state) % 10000);
+            }
+        }
+        out += "]}";
+        index++;
+    }
+    out += "]";
+}
+
+uint64_t Corpus::next(uint64_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+void Corpus::appendWord(std::string &out, size_t length, uint64_t &state)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        out += static_cast<char>('a' + next(state) % 26);
+    }
+}
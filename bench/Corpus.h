@@ -0,0 +1,82 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Enum representing the shape of a synthetic JSON document.
+ */
+enum class CorpusKind
+{
+    DEEP_NESTING,
+    WIDE_OBJECT,
+    LARGE_ARRAY,
+    STRING_HEAVY,
+    NUMBER_HEAVY
+};
+
+/**
+ * Generates deterministic synthetic JSON documents for benchmarking.
+ *
+ * Every document is an object with a small "meta" object, which the mutating
+ * benchmarks operate on, and a "data" member holding the bulk of the payload.
+ * The same kind and size always produce the same bytes.
+ */
+class Corpus
+{
+public:
+    /**
+     * Generates a document of roughly the given size.
+     *
+     * @param kind the shape of the document
+     * @param targetBytes approximate size of the document in bytes
+     *
+     * @return the JSON text
+     */
+    static std::string generate(CorpusKind kind, size_t targetBytes);
+
+    /**
+     * Returns the name of a corpus kind, as used in benchmark reports.
+     */
+    static std::string name(CorpusKind kind);
+
+    /**
+     * Returns all corpus kinds.
+     */
+    static std::vector<CorpusKind> allKinds();
+
+    /**
+     * Returns the key the search benchmarks look for in every corpus.
+     */
+    static std::string searchKey();
+
+    /**
+     * Returns a JSON Schema that every document of a kind conforms to.
+     */
+    static std::string schema(CorpusKind kind);
+
+private:
+    static void deepNesting(std::string &out, size_t targetBytes, uint64_t &state);
+    static void wideObject(std::string &out, size_t targetBytes, uint64_t &state);
+    static void largeArray(std::string &out, size_t targetBytes, uint64_t &state);
+    static void stringHeavy(std::string &out, size_t targetBytes, uint64_t &state);
+    static void numberHeavy(std::string &out, size_t targetBytes, uint64_t &state);
+
+    /**
+     * Advances a xorshift64 generator.
+     *
+     * @param state the generator state
+     *
+     * @return the next pseudo-random number
+     */
+    static uint64_t next(uint64_t &state);
+
+    /**
+     * Appends a pseudo-random lowercase word of the given length.
+     */
+    static void appendWord(std::string &out, size_t length, uint64_t &state);
+};
+
+#endif
@@ -0,0 +1,519 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <thread>
+
+#include "Benchmark.h"
+#include "Corpus.h"
+
+#include "Parser.h"
+#include "PathExtractor.h"
+#include "PushParser.h"
+#include "ThreadPool.h"
+
+namespace
+{
+    /**
+     * Stream buffer discarding everything written to it, so that printing
+     * benchmarks measure serialization rather than the terminal.
+     */
+    class NullBuffer : public std::streambuf
+    {
+    protected:
+        int overflow(int c) override
+        {
+            return c;
+        }
+
+        std::streamsize xsputn(const char *, std::streamsize count) override
+        {
+            return count;
+        }
+    };
+
+    /**
+     * SAX-style sink that only counts the values it receives, standing in
+     * for a consumer that reads the document without building a tree.
+     */
+    class CountingSink
+    {
+    public:
+        void startObject(size_t) { values++; }
+        void endObject(size_t) {}
+        void startArray(size_t) { values++; }
+        void endArray(size_t) {}
+        void key(std::string_view) {}
+        void string(std::string_view) { values++; }
+        void number(std::string_view) { values++; }
+        void boolean(bool) { values++; }
+        void null() { values++; }
+
+        size_t values = 0;
+    };
+
+    template <typename Sink>
+    Sink makeSink(StatCounters &)
+    {
+        return Sink();
+    }
+
+    template <>
+    DomSink makeSink<DomSink>(StatCounters &stats)
+    {
+        return DomSink(stats);
+    }
+
+    /**
+     * Runs one instantiation of BasicParser over the input. An allocator
+     * other than std::allocator is given a fresh arena with a stack buffer
+     * in every iteration.
+     */
+    template <typename Sink, typename Position, typename Allocator = std::allocator<char>>
+    void runCore(Benchmark &benchmark, const std::string &name, const std::string &corpusName, const std::string &input)
+    {
+        if (!benchmark.selected(name))
+        {
+            return;
+        }
+
+        StatCounters stats;
+        benchmark.run(name, corpusName, input.size(), [&]()
+                      {
+                          Sink sink = makeSink<Sink>(stats);
+                          if constexpr (std::is_same<Allocator, std::allocator<char>>::value)
+                          {
+                              BasicParser<Sink, Position> parser(input);
+                              parser.parse(sink);
+                          }
+                          else
+                          {
+                              char buffer[16 * 1024];
+                              std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+                              BasicParser<Sink, Position, Allocator> parser(input, DEFAULT_MAX_DEPTH, 0, Allocator(&arena));
+                              parser.parse(sink);
+                          } });
+    }
+
+    void usage()
+    {
+        std::cerr << "Usage: json-bench [--sizes <size>[,<size>...]] [--corpus <name>] [--filter <text>]" << std::endl;
+        std::cerr << "                  [--iterations <n>] [--min-time <seconds>]" << std::endl;
+        std::cerr << "Sizes accept KB, MB and GB suffixes, e.g. --sizes 64KB,1MB,1GB." << std::endl;
+        std::cerr << "Results are written to stdout as one JSON object per line." << std::endl;
+    }
+
+    size_t parseSize(const std::string &text)
+    {
+        size_t multiplier = 1;
+        std::string digits = text;
+        if (digits.size() > 2)
+        {
+            std::string suffix = digits.substr(digits.size() - 2);
+            if (suffix == "KB" || suffix == "kb")
+            {
+                multiplier = 1024;
+            }
+            else if (suffix == "MB" || suffix == "mb")
+            {
+                multiplier = 1024 * 1024;
+            }
+            else if (suffix == "GB" || suffix == "gb")
+            {
+                multiplier = 1024 * 1024 * 1024;
+            }
+
+            if (multiplier != 1)
+            {
+                digits = digits.substr(0, digits.size() - 2);
+            }
+        }
+        return static_cast<size_t>(std::stoull(digits)) * multiplier;
+    }
+
+    std::vector<size_t> parseSizes(const std::string &text)
+    {
+        std::vector<size_t> sizes;
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ','))
+        {
+            if (!item.empty())
+            {
+                sizes.push_back(parseSize(item));
+            }
+        }
+        return sizes;
+    }
+
+    /**
+     * Searches a document while another thread applies writes to it at a
+     * fixed rate, so read cost can be compared across write rates.
+     *
+     * @param writesPerSecond rate of the writer thread, 0 for no writer and SIZE_MAX for no pause
+     */
+    void runSharedSearch(Benchmark &benchmark, const std::string &name, const std::string &corpusName,
+                         const std::string &input, size_t writesPerSecond)
+    {
+        Parser document(input);
+        std::atomic<bool> stop{false};
+        std::thread writer;
+
+        if (writesPerSecond != 0)
+        {
+            writer = std::thread([&]()
+                                 {
+                                     size_t counter = 0;
+                                     while (!stop.load())
+                                     {
+                                         document.set("meta/version", std::to_string(++counter));
+                                         if (writesPerSecond != SIZE_MAX)
+                                         {
+                                             std::this_thread::sleep_for(std::chrono::microseconds(1000000 / writesPerSecond));
+                                         }
+                                     } });
+        }
+
+        benchmark.run(name, corpusName, input.size(), [&]()
+                      { document.searchKey(Corpus::searchKey()); });
+
+        stop.store(true);
+        if (writer.joinable())
+        {
+            writer.join();
+        }
+    }
+
+    /**
+     * Parses a copy of the input on each of several threads at once, each
+     * with its own ParseContext, so that the aggregate throughput shows how
+     * parsing scales with threads.
+     */
+    void runParallelParse(Benchmark &benchmark, const std::string &name, const std::string &corpusName,
+                          const std::string &input, size_t threads)
+    {
+        ThreadPool pool(threads);
+        std::vector<std::string> inputs(threads, input);
+        std::vector<std::unique_ptr<ParseContext>> contexts;
+        for (size_t i = 0; i < threads; i++)
+        {
+            contexts.emplace_back(new ParseContext());
+        }
+
+        benchmark.run(name, corpusName, input.size() * threads, [&]()
+                      {
+                          for (size_t i = 0; i < threads; i++)
+                          {
+                              pool.submit([&, i]()
+                                          { contexts[i]->parse(inputs[i]); });
+                          }
+                          pool.wait(); });
+    }
+
+    void runCorpus(Benchmark &benchmark, CorpusKind kind, size_t size)
+    {
+        const std::string corpusName = Corpus::name(kind) + "-" + std::to_string(size);
+        const std::string input = Corpus::generate(kind, size);
+        const size_t bytes = input.size();
+
+        if (benchmark.selected("lexer/next-token"))
+        {
+            benchmark.run("lexer/next-token", corpusName, bytes, [&]()
+                          {
+                              Lexer lexer(input);
+                              while (lexer.nextToken().type != TokenType::END)
+                              {
+                              } });
+        }
+
+        runCore<DomSink, NoPosition>(benchmark, "core/dom", corpusName, input);
+        runCore<DomSink, TrackPosition>(benchmark, "core/dom-track-position", corpusName, input);
+        runCore<CountingSink, NoPosition>(benchmark, "core/sax", corpusName, input);
+        runCore<ValidateSink, NoPosition>(benchmark, "core/validate", corpusName, input);
+        runCore<ValidateSink, TrackPosition>(benchmark, "core/validate-track-position", corpusName, input);
+        runCore<ValidateSink, NoPosition, std::pmr::polymorphic_allocator<char>>(benchmark, "core/validate-arena", corpusName, input);
+
+        if (benchmark.selected("core/validate-schema"))
+        {
+            // Syntax and schema checked in one pass, to compare with core/validate.
+            Parser schemaParser(Corpus::schema(kind));
+            std::unique_ptr<JSONValue> schemaDocument = schemaParser.takeRoot();
+            Schema schema(schemaDocument.get());
+            benchmark.run("core/validate-schema", corpusName, bytes, [&]()
+                          {
+                              SchemaSink sink(schema);
+                              BasicParser<SchemaSink> parser(input);
+                              parser.parse(sink);
+                          });
+        }
+
+        std::vector<size_t> threadCounts = {1, 2, 4};
+        if (std::thread::hardware_concurrency() > 4)
+        {
+            threadCounts.push_back(std::thread::hardware_concurrency());
+        }
+        for (size_t threads : threadCounts)
+        {
+            std::string name = "parse/context-" + std::to_string(threads) + (threads == 1 ? "-thread" : "-threads");
+            if (benchmark.selected(name))
+            {
+                runParallelParse(benchmark, name, corpusName, input, threads);
+            }
+        }
+
+        if (benchmark.selected("parser/construct"))
+        {
+            benchmark.run("parser/construct", corpusName, bytes, [&]()
+                          { Parser parser(input); });
+        }
+
+        if (benchmark.selected("push/validate-4k-chunks"))
+        {
+            benchmark.run("push/validate-4k-chunks", corpusName, bytes, [&]()
+                          {
+                              ValidateSink sink;
+                              PushParser<ValidateSink> parser(sink);
+                              for (size_t pos = 0; pos < input.size(); pos += 4096)
+                              {
+                                  parser.feed(input.data() + pos, std::min<size_t>(4096, input.size() - pos));
+                              }
+                              parser.finish();
+                          });
+        }
+
+        if (benchmark.selected("extractor/get-missing"))
+        {
+            // A missing key makes the extractor skip over the whole document.
+            benchmark.run("extractor/get-missing", corpusName, bytes, [&]()
+                          {
+                              std::istringstream in(input);
+                              PathExtractor::extract(in, "key-that-is-not-present");
+                          });
+        }
+
+        Parser parser(input);
+
+        // Failures of the edit commands are reported here rather than on
+        // stderr, where they would interleave with the results.
+        NullBuffer quietBuffer;
+        std::ostream quiet(&quietBuffer);
+
+        if (benchmark.selected("validator/validate"))
+        {
+            benchmark.run("validator/validate", corpusName, bytes, [&]()
+                          { parser.validate(); });
+        }
+
+        if (benchmark.selected("searcher/search-by-key"))
+        {
+            benchmark.run("searcher/search-by-key", corpusName, bytes, [&]()
+                          { parser.searchKey(Corpus::searchKey()); });
+        }
+
+        if (benchmark.selected("searcher/search-missing-key"))
+        {
+            // Large subtrees are ruled out by their key filters instead of walked.
+            benchmark.run("searcher/search-missing-key", corpusName, bytes, [&]()
+                          { parser.searchKey("key-that-is-not-present"); });
+        }
+
+        if (benchmark.selected("searcher/stream-first-match"))
+        {
+            // Stops at the first match, as search <key> --limit 1 does.
+            NullBuffer nullBuffer;
+            std::ostream out(&nullBuffer);
+            benchmark.run("searcher/stream-first-match", corpusName, bytes, [&]()
+                          { parser.searchKey(Corpus::searchKey(), out, 1); });
+        }
+
+        if (benchmark.selected("parser/contains"))
+        {
+            benchmark.run("parser/contains", corpusName, bytes, [&]()
+                          { parser.contains("value-that-is-not-present"); });
+        }
+
+        if (benchmark.selected("differ/diff-one-change"))
+        {
+            // Two versions of the document that differ in one value.
+            Parser changed(input);
+            changed.set("meta/version", "\"changed\"");
+            std::unique_ptr<JSONValue> target = changed.takeRoot();
+            NullBuffer nullBuffer;
+            std::ostream out(&nullBuffer);
+            benchmark.run("differ/diff-one-change", corpusName, bytes, [&]()
+                          { parser.diff(target.get(), out); });
+        }
+
+        if (benchmark.selected("printer/print"))
+        {
+            NullBuffer nullBuffer;
+            std::ostream out(&nullBuffer);
+            benchmark.run("printer/print", corpusName, bytes, [&]()
+                          { parser.print(out); });
+        }
+
+        if (benchmark.selected("canonicalizer/write"))
+        {
+            // The first write sorts every object; the others reuse the sorted orders.
+            std::unique_ptr<JSONValue> document = Parser(input).takeRoot();
+            NullBuffer nullBuffer;
+            std::ostream out(&nullBuffer);
+            benchmark.run("canonicalizer/write", corpusName, bytes, [&]()
+                          { Canonicalizer::write(out, document.get()); });
+        }
+
+        if (benchmark.selected("parser/write-json"))
+        {
+            benchmark.run("parser/write-json", corpusName, bytes, [&]()
+                          { parser.saveas("", "/dev/null"); });
+        }
+
+        if (benchmark.selected("command/set"))
+        {
+            size_t counter = 0;
+            benchmark.run("command/set", corpusName, bytes, [&]()
+                          { parser.set("meta/version", std::to_string(++counter), nullptr, quiet); });
+        }
+
+        // Whether meta/scratch exists, so that the create and delete
+        // benchmarks each start from the state they need whatever ran before.
+        bool scratchExists = false;
+
+        if (benchmark.selected("command/create"))
+        {
+            benchmark.run(
+                "command/create", corpusName, bytes, [&]()
+                { scratchExists = parser.create("meta/scratch", "\"value\"", quiet); },
+                [&]()
+                {
+                    if (scratchExists && parser.deleteElement("meta/scratch", quiet))
+                    {
+                        scratchExists = false;
+                    }
+                });
+        }
+
+        if (benchmark.selected("command/delete"))
+        {
+            benchmark.run(
+                "command/delete", corpusName, bytes, [&]()
+                {
+                    if (parser.deleteElement("meta/scratch", quiet))
+                    {
+                        scratchExists = false;
+                    }
+                },
+                [&]()
+                {
+                    if (!scratchExists)
+                    {
+                        scratchExists = parser.create("meta/scratch", "\"value\"", quiet);
+                    }
+                });
+        }
+
+        if (benchmark.selected("command/move"))
+        {
+            // Every move runs on a freshly parsed document, so its cost does
+            // not depend on the outcome of the previous iteration.
+            std::unique_ptr<Parser> fresh;
+            benchmark.run(
+                "command/move", corpusName, bytes, [&]()
+                { fresh->move("meta/owner", "meta/moved/owner", quiet); },
+                [&]()
+                { fresh.reset(new Parser(input)); });
+        }
+
+        const std::pair<const char *, size_t> writeRates[] = {
+            {"shared/search-no-writes", 0},
+            {"shared/search-1k-writes-per-second", 1000},
+            {"shared/search-continuous-writes", SIZE_MAX}};
+        for (const auto &rate : writeRates)
+        {
+            if (benchmark.selected(rate.first))
+            {
+                runSharedSearch(benchmark, rate.first, corpusName, input, rate.second);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    BenchmarkOptions options;
+    std::vector<size_t> sizes = {64 * 1024, 1024 * 1024};
+    std::string corpusFilter;
+    std::string nameFilter;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            usage();
+            return 0;
+        }
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--sizes")
+        {
+            sizes = parseSizes(value);
+        }
+        else if (arg == "--corpus")
+        {
+            corpusFilter = value;
+        }
+        else if (arg == "--filter")
+        {
+            nameFilter = value;
+        }
+        else if (arg == "--iterations")
+        {
+            options.minIterations = options.maxIterations = std::stoul(value);
+            options.minSeconds = 0;
+        }
+        else if (arg == "--min-time")
+        {
+            options.minSeconds = std::stod(value);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    // Results go through their own stream, because the printing benchmarks
+    // temporarily redirect std::cout.
+    std::ostream results(std::cout.rdbuf());
+    Benchmark benchmark(options, results);
+    benchmark.setFilter(nameFilter);
+
+    try
+    {
+        for (size_t size : sizes)
+        {
+            for (CorpusKind kind : Corpus::allKinds())
+            {
+                if (corpusFilter.empty() || Corpus::name(kind) == corpusFilter)
+                {
+                    runCorpus(benchmark, kind, size);
+                }
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
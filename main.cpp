@@ -1,6 +1,10 @@
+#include <unistd.h>
+
 #include "Engine.h"
+#include "Server.h"
+#include "StreamValidator.h"
 
-int main()
+int main(int argc, char *argv[])
 {
     // Sample commands for execution [open example.json]
     // create newPath "newValue"
@@ -9,8 +13,72 @@ int main()
     // move management newPath
     // saveas a.json newPath
 
+    // Daemon mode: json-parser --serve <socket> [<file>]
+    // keeps the document parsed and answers commands sent over the socket.
+    // Batch mode: json-parser --validate-all <dir|glob> [<threads>]
+    // validates many files in parallel and fails if any is invalid.
+    // Stream mode: json-parser --validate-stdin
+    // validates JSON read from a pipe as it arrives, without waiting for the end;
+    // gzip or zstd compressed input is decompressed on the way.
+    // Lookup mode: json-parser --get <file> <path>
+    // prints the value at a path without parsing the rest of the file.
+
     try
     {
+        std::string mode = argc > 1 ? argv[1] : "";
+        if (mode == "--serve")
+        {
+            if (argc < 3 || argc > 4)
+            {
+                std::cerr << "Usage: json-parser --serve <socket> [<file>]" << std::endl;
+                return 1;
+            }
+
+            Server server(argv[2], argc == 4 ? argv[3] : "");
+            server.run();
+            return 0;
+        }
+
+        if (mode == "--validate-all")
+        {
+            if (argc < 3 || argc > 4)
+            {
+                std::cerr << "Usage: json-parser --validate-all <dir|glob> [<threads>]" << std::endl;
+                return 1;
+            }
+
+            std::vector<std::string> files = BulkValidator::findFiles(argv[2]);
+            BulkValidationSummary summary = BulkValidator::validateAll(files, argc == 4 ? std::stoul(argv[3]) : 0);
+            BulkValidator::print(summary, std::cout);
+            return summary.invalidCount == 0 ? 0 : 1;
+        }
+
+        if (mode == "--validate-stdin")
+        {
+            StreamValidator::validate(STDIN_FILENO);
+            std::cout << "Valid JSON." << std::endl;
+            return 0;
+        }
+
+        if (mode == "--get")
+        {
+            if (argc != 4)
+            {
+                std::cerr << "Usage: json-parser --get <file> <path>" << std::endl;
+                return 1;
+            }
+
+            std::unique_ptr<JSONValue> value = PathExtractor::extract(argv[2], argv[3]);
+            if (!value)
+            {
+                std::cerr << "Path not found: " << argv[3] << std::endl;
+                return 1;
+            }
+            Printer::print(value.get());
+            std::cout << std::endl;
+            return 0;
+        }
+
         Engine engine;
         engine.prompt();
     }
@@ -21,4 +89,4 @@ int main()
     }
 
     return 0;
-}
\ No newline at end of file
+}